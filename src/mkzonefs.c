@@ -6,77 +6,20 @@
  * Authors: Damien Le Moal (damien.lemoal@wdc.com)
  */
 
+#include "config.h"
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
 #include <errno.h>
 #include <limits.h>
+#include <ctype.h>
+#include <pthread.h>
 #include <sys/types.h>
 #include <sys/stat.h>
-#include <asm/byteorder.h>
 
-#include "zonefs.h"
-
-/*
- * For super block checksum (CRC32)
- */
-#define CRCPOLY_LE 0xedb88320
-
-__u32 zonefs_crc32(__u32 crc, const void *buf, size_t length)
-{
-        unsigned char *p = (unsigned char *)buf;
-        int i;
-
-        while (length--) {
-                crc ^= *p++;
-                for (i = 0; i < 8; i++)
-                        crc = (crc >> 1) ^ ((crc & 1) ? CRCPOLY_LE : 0);
-        }
-
-        return crc;
-}
-
-/*
- * Fill and write a super block.
- */
-static int zonefs_write_super(struct zonefs_dev *dev)
-{
-	struct zonefs_super *super;
-	__u32 crc;
-	int ret;
-
-	ret = posix_memalign((void **)&super, sysconf(_SC_PAGESIZE),
-			     sizeof(*super));
-	if (ret) {
-		fprintf(stderr, "Not enough memory\n");
-		return -1;
-	}
-
-	memset(super, 0, sizeof(*super));
-	super->s_magic = __cpu_to_le32(ZONEFS_MAGIC);
-	uuid_copy(super->s_uuid, dev->uuid);
-	strcpy(super->s_label, dev->label);
-	super->s_features = __cpu_to_le64(dev->features);
-	super->s_uid = __cpu_to_le32(dev->uid);
-	super->s_gid = __cpu_to_le32(dev->gid);
-	super->s_perm = __cpu_to_le32(dev->perm);
-
-	crc = zonefs_crc32(~0U, super, sizeof(*super));
-	super->s_crc = __cpu_to_le32(crc);
-
-	ret = pwrite(dev->fd, super, sizeof(*super), 0);
-	free(super);
-
-	if (ret < 0) {
-		fprintf(stderr,
-			"%s: Write super block failed %d (%s)\n",
-			dev->name, errno, strerror(errno));
-		return -1;
-	}
-
-	return zonefs_finish_zone(dev, &dev->zones[0]);
-}
+#include "zonefs_priv.h"
 
 /*
  * Parse features string.
@@ -131,42 +74,562 @@ static int zonefs_parse_features(struct zonefs_dev *dev, char *features)
 	return 0;
 }
 
+/*
+ * Per device format job.
+ */
+struct mkzonefs_job {
+	char			*dev_path;
+	struct zonefs_dev	dev;
+
+	/* Buffered output when formatting several devices */
+	char			*out;
+	size_t			out_size;
+
+	unsigned long long	elapsed;
+	int			ret;
+};
+
+/*
+ * Batch format context.
+ */
+struct mkzonefs_batch {
+	struct mkzonefs_job	*jobs;
+	unsigned int		nr_jobs;
+	unsigned int		max_jobs;
+	unsigned int		next_job;
+};
+
 /*
  * Print usage.
  */
 static void mkzonefs_usage(void)
 {
-	printf("Usage: mkzonefs [options] <device path>\n");
+	printf("Usage: mkzonefs [options] <device path> [<device path> ...]\n");
 	printf("Options:\n"
 	       "  --version     : Print version number and exit\n"
 	       "  --help | -h   : General help message\n"
 	       "  -v            : Verbose output\n"
 	       "  -f            : Force overwrite of existing content\n"
+	       "  -i            : Incremental format: only reset sequential\n"
+	       "                  zones that are not empty\n"
+	       "  -n            : Dry run: print the zones that would be\n"
+	       "                  reset and exit without formatting\n"
+	       "  -j <num>      : Number of threads to use for zone report\n"
+	       "                  and reset (default: number of CPUs)\n"
+	       "  -D <file>     : Also format the devices listed in <file>\n"
+	       "                  (one device path per line)\n"
+	       "  -P <num>      : Format at most <num> devices in parallel\n"
+	       "                  (default: number of CPUs)\n"
+	       "  -w <mode>     : Wipe conventional zones, zeroing them out\n"
+	       "                  (zero) or discarding them (discard)\n"
+	       "  -B <MiB/s>    : Limit the conventional zones wipe\n"
+	       "                  bandwidth\n"
+	       "  --stats       : Print device information, format phases\n"
+	       "                  time and ioctl counts in JSON format\n"
+	       "                  instead of the regular output\n"
 	       "  -o <features>	: Optional features\n");
 }
 
+/*
+ * Conventional zones wipe mode names.
+ */
+static const char *mkzonefs_wipe_name(unsigned int wipe)
+{
+	switch (wipe) {
+	case ZONEFS_WIPE_ZERO:
+		return "zero";
+	case ZONEFS_WIPE_DISCARD:
+		return "discard";
+	default:
+		return "none";
+	}
+}
+
+/*
+ * Print the error of a failed library call.
+ */
+static void mkzonefs_print_error(struct zonefs_dev *dev)
+{
+	const char *msg = zonefs_dev_error(dev);
+
+	fprintf(stderr, "%s\n", msg ? msg : "Unknown error");
+	if (zonefs_dev_errno(dev) == EEXIST)
+		fprintf(stderr, "Use the option '-f' to overwrite\n");
+}
+
+/*
+ * Format a device, printing information to out.
+ */
+static int mkzonefs_format(struct zonefs_dev *dev, char *dev_path, FILE *out)
+{
+	char uuid_str[UUID_STR_LEN];
+	unsigned long long elapsed;
+	unsigned int nr_zones;
+	bool pipelined;
+	int ret = 1;
+
+	/* Have the library print the zones, plans and progress to out too */
+	dev->out = out;
+
+	/* Get device path */
+	dev->path = realpath(dev_path, NULL);
+	if (!dev->path) {
+		fprintf(stderr, "%s: Failed to get device real path\n",
+			dev_path);
+		return 1;
+	}
+
+	/*
+	 * Open the device. If the zone reset can be pipelined with the zone
+	 * report, the zones are reset while the device is being opened.
+	 */
+	pipelined = zonefs_dev_pipelined(dev);
+	if (pipelined) {
+		fprintf(out,
+			"Resetting %ssequential zones while reporting zones\n",
+			dev->flags & ZONEFS_INCREMENTAL ? "non-empty " : "");
+		fflush(out);
+		if (zonefs_open_reset_dev(dev, true) < 0) {
+			mkzonefs_print_error(dev);
+			goto free;
+		}
+		elapsed = dev->stats.phase_usec[ZONEFS_PHASE_ZONE_RESET];
+		fprintf(out, "  Done in %llu.%03llu s\n",
+			elapsed / 1000000, (elapsed % 1000000) / 1000);
+	} else if (zonefs_open_dev(dev, true) < 0) {
+		mkzonefs_print_error(dev);
+		goto free;
+	}
+
+	fprintf(out, "%s: %llu 512-byte sectors (%llu GiB)\n",
+		dev->path,
+		dev->capacity,
+		(dev->capacity << 9) / (1024ULL * 1024ULL * 1024ULL));
+	fprintf(out, "  Host-%s device\n",
+		(dev->model == ZONEFS_DEV_HM) ? "managed" : "aware");
+	nr_zones = dev->capacity / dev->zone_nr_sectors;
+	fprintf(out, "  %u zones of %zu 512-byte sectors (%zu MiB)\n",
+		nr_zones,
+		dev->zone_nr_sectors,
+		(dev->zone_nr_sectors << 9) / (1024 * 1024));
+	if (nr_zones < dev->nr_zones) {
+		size_t runt_sectors = dev->capacity & (dev->zone_nr_sectors - 1);
+
+		fprintf(out, "  1 runt zone of %zu 512-byte sectors (%zu MiB)\n",
+			runt_sectors,
+			(runt_sectors << 9) / (1024 * 1024));
+	}
+	fprintf(out, "  %u conventional zones, %u sequential zones\n",
+		dev->nr_conv_zones, dev->nr_seq_zones);
+	fprintf(out, "  %u read-only zones, %u offline zones\n",
+		dev->nr_ro_zones, dev->nr_ol_zones);
+
+	if (dev->nr_ol_zones >= dev->nr_zones - 1) {
+		fprintf(stderr, "%s: No useable zones\n", dev->path);
+		goto out;
+	}
+
+	fprintf(out, "Format:\n");
+	fprintf(out, "  %u usable zones\n", dev->nr_zones - dev->nr_ol_zones - 1);
+	fprintf(out, "  Aggregate conventional zones: %s\n",
+		dev->features & ZONEFS_F_AGGRCNV ? "enabled" : "disabled");
+	fprintf(out, "  File UID: %u\n", dev->uid);
+	fprintf(out, "  File GID: %u\n", dev->gid);
+	fprintf(out, "  File access permissions: %o\n", dev->perm);
+
+	if (dev->wipe != ZONEFS_WIPE_NONE) {
+		fprintf(out, "  Conventional zones wipe: %s",
+			mkzonefs_wipe_name(dev->wipe));
+		if (dev->wipe_bw)
+			fprintf(out, " (%llu MiB/s max)",
+				dev->wipe_bw / (1024 * 1024));
+		fprintf(out, "\n");
+	}
+
+	if (strlen(dev->label))
+		fprintf(out, "  FS label: %s\n", dev->label);
+
+	uuid_generate(dev->uuid);
+	uuid_unparse(dev->uuid, uuid_str);
+	fprintf(out, "  FS UUID: %s\n", uuid_str);
+
+	if (dev->flags & ZONEFS_DRY_RUN) {
+		fprintf(out, "Dry run, not formatting\n");
+		fflush(out);
+		if (zonefs_reset_zones(dev) < 0 ||
+		    zonefs_wipe_cnv_zones(dev) < 0) {
+			mkzonefs_print_error(dev);
+			goto out;
+		}
+		ret = 0;
+		goto out;
+	}
+
+	if (!pipelined) {
+		if (dev->flags & ZONEFS_INCREMENTAL)
+			fprintf(out, "Resetting non-empty sequential zones\n");
+		else
+			fprintf(out, "Resetting sequential zones\n");
+		fflush(out);
+		if (zonefs_reset_zones(dev) < 0) {
+			mkzonefs_print_error(dev);
+			goto out;
+		}
+		elapsed = dev->stats.phase_usec[ZONEFS_PHASE_ZONE_RESET];
+		fprintf(out, "  Done in %llu.%03llu s\n",
+			elapsed / 1000000, (elapsed % 1000000) / 1000);
+	}
+
+	if (dev->wipe != ZONEFS_WIPE_NONE) {
+		fprintf(out, "Wiping conventional zones (%s)\n",
+			mkzonefs_wipe_name(dev->wipe));
+		fflush(out);
+		if (zonefs_wipe_cnv_zones(dev) < 0) {
+			mkzonefs_print_error(dev);
+			goto out;
+		}
+		elapsed = dev->stats.phase_usec[ZONEFS_PHASE_CNV_WIPE];
+		fprintf(out, "  Done in %llu.%03llu s\n",
+			elapsed / 1000000, (elapsed % 1000000) / 1000);
+	}
+
+	fprintf(out, "Writing super block\n");
+	if (zonefs_write_super(dev) < 0) {
+		mkzonefs_print_error(dev);
+		goto out;
+	}
+
+	/* Sync */
+	if (zonefs_sync_dev(dev) < 0) {
+		mkzonefs_print_error(dev);
+		goto out;
+	}
+
+	ret = 0;
+
+out:
+	zonefs_close_dev(dev);
+free:
+	free(dev->path);
+	dev->path = NULL;
+
+	return ret;
+}
+
+/*
+ * Add a device to a batch.
+ */
+static int mkzonefs_add_job(struct mkzonefs_batch *batch,
+			    struct zonefs_dev *dev, char *dev_path)
+{
+	struct mkzonefs_job *jobs;
+
+	if (batch->nr_jobs == batch->max_jobs) {
+		batch->max_jobs = batch->max_jobs ? batch->max_jobs * 2 : 8;
+		jobs = realloc(batch->jobs,
+			       batch->max_jobs * sizeof(struct mkzonefs_job));
+		if (!jobs) {
+			fprintf(stderr, "Not enough memory\n");
+			return -1;
+		}
+		batch->jobs = jobs;
+	}
+
+	jobs = &batch->jobs[batch->nr_jobs];
+	memset(jobs, 0, sizeof(struct mkzonefs_job));
+	jobs->dev = *dev;
+	jobs->dev_path = strdup(dev_path);
+	if (!jobs->dev_path) {
+		fprintf(stderr, "Not enough memory\n");
+		return -1;
+	}
+	batch->nr_jobs++;
+
+	return 0;
+}
+
+/*
+ * Add the devices listed in a file to a batch. Empty lines and lines
+ * starting with '#' are ignored.
+ */
+static int mkzonefs_add_job_list(struct mkzonefs_batch *batch,
+				 struct zonefs_dev *dev, char *list_path)
+{
+	char *line = NULL, *p;
+	size_t line_size = 0;
+	ssize_t len;
+	FILE *f;
+	int ret = 0;
+
+	f = fopen(list_path, "r");
+	if (!f) {
+		fprintf(stderr, "Open %s failed %d (%s)\n",
+			list_path, errno, strerror(errno));
+		return -1;
+	}
+
+	while ((len = getline(&line, &line_size, f)) > 0) {
+		while (len && isspace(line[len - 1]))
+			line[--len] = '\0';
+		p = line;
+		while (isspace(*p))
+			p++;
+		if (!*p || *p == '#')
+			continue;
+		ret = mkzonefs_add_job(batch, dev, p);
+		if (ret)
+			break;
+	}
+
+	free(line);
+	fclose(f);
+
+	return ret;
+}
+
+static void *mkzonefs_job_worker(void *arg)
+{
+	struct mkzonefs_batch *batch = arg;
+	struct mkzonefs_job *job;
+	unsigned long long start;
+	unsigned int i;
+	FILE *out;
+
+	while (1) {
+		i = __atomic_fetch_add(&batch->next_job, 1, __ATOMIC_RELAXED);
+		if (i >= batch->nr_jobs)
+			break;
+
+		job = &batch->jobs[i];
+		start = zonefs_usec();
+		out = open_memstream(&job->out, &job->out_size);
+		if (!out) {
+			fprintf(stderr, "%s: Not enough memory\n",
+				job->dev_path);
+			job->ret = 1;
+			continue;
+		}
+		job->ret = mkzonefs_format(&job->dev, job->dev_path, out);
+		fclose(out);
+		job->elapsed = zonefs_usec() - start;
+	}
+
+	return NULL;
+}
+
+static const char *mkzonefs_phase_name[ZONEFS_NR_PHASES] = {
+	[ZONEFS_PHASE_MOUNT_CHECK]	= "mount_check",
+	[ZONEFS_PHASE_BUSY_CHECK]	= "busy_check",
+	[ZONEFS_PHASE_PROBE]		= "probe",
+	[ZONEFS_PHASE_DEV_INFO]		= "dev_info",
+	[ZONEFS_PHASE_ZONE_REPORT]	= "zone_report",
+	[ZONEFS_PHASE_ZONE_RESET]	= "zone_reset",
+	[ZONEFS_PHASE_CNV_WIPE]		= "cnv_wipe",
+	[ZONEFS_PHASE_SUPER]		= "super",
+	[ZONEFS_PHASE_SYNC]		= "sync",
+};
+
+/*
+ * Print a JSON string.
+ */
+static void mkzonefs_json_str(const char *str)
+{
+	putchar('"');
+	for (; *str; str++) {
+		if (*str == '"' || *str == '\\')
+			printf("\\%c", *str);
+		else if ((unsigned char)*str < 0x20)
+			printf("\\u%04x", *str);
+		else
+			putchar(*str);
+	}
+	putchar('"');
+}
+
+/*
+ * Print a device statistics as a JSON object.
+ */
+static void mkzonefs_print_job_stats(struct mkzonefs_job *job, bool last)
+{
+	struct zonefs_dev *dev = &job->dev;
+	struct zonefs_stats *st = &dev->stats;
+	const char *model;
+	int i;
+
+	switch (dev->model) {
+	case ZONEFS_DEV_HM:
+		model = "host-managed";
+		break;
+	case ZONEFS_DEV_HA:
+		model = "host-aware";
+		break;
+	default:
+		model = "unknown";
+		break;
+	}
+
+	printf("    {\n");
+	printf("      \"path\": ");
+	mkzonefs_json_str(job->dev_path);
+	printf(",\n");
+	printf("      \"result\": \"%s\",\n", job->ret ? "failed" : "ok");
+	printf("      \"model\": \"%s\",\n", model);
+	printf("      \"capacity_sectors\": %llu,\n", dev->capacity);
+	printf("      \"zone_sectors\": %zu,\n", dev->zone_nr_sectors);
+	printf("      \"nr_zones\": %u,\n", dev->nr_zones);
+	printf("      \"nr_conv_zones\": %u,\n", dev->nr_conv_zones);
+	printf("      \"nr_seq_zones\": %u,\n", dev->nr_seq_zones);
+	printf("      \"nr_ro_zones\": %u,\n", dev->nr_ro_zones);
+	printf("      \"nr_ol_zones\": %u,\n", dev->nr_ol_zones);
+	printf("      \"elapsed_usec\": %llu,\n", job->elapsed);
+	printf("      \"phases_usec\": {\n");
+	for (i = 0; i < ZONEFS_NR_PHASES; i++)
+		printf("        \"%s\": %llu%s\n",
+		       mkzonefs_phase_name[i], st->phase_usec[i],
+		       i == ZONEFS_NR_PHASES - 1 ? "" : ",");
+	printf("      },\n");
+	printf("      \"overlap_usec\": %llu,\n", st->overlap_usec);
+	printf("      \"ioctls\": {\n");
+	printf("        \"report\": %llu,\n", st->nr_report_ioctls);
+	printf("        \"reset\": %llu,\n", st->nr_reset_ioctls);
+	printf("        \"finish\": %llu,\n", st->nr_finish_ioctls);
+	printf("        \"wipe\": %llu,\n", st->nr_wipe_ioctls);
+	printf("        \"other\": %llu\n", st->nr_other_ioctls);
+	printf("      }\n");
+	printf("    }%s\n", last ? "" : ",");
+}
+
+/*
+ * Format all devices of a batch using at most nr_workers threads and
+ * print a summary, or the devices statistics in JSON format.
+ */
+static int mkzonefs_run_batch(struct mkzonefs_batch *batch,
+			      unsigned int nr_workers, bool stats)
+{
+	unsigned long long start, elapsed;
+	unsigned int i, nr_threads, nr_failed = 0;
+	struct mkzonefs_job *job;
+	pthread_t *threads;
+	long nr_cpus;
+	int ret;
+
+	if (!nr_workers) {
+		nr_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		nr_workers = nr_cpus > 0 ? nr_cpus : 1;
+	}
+	if (nr_workers > batch->nr_jobs)
+		nr_workers = batch->nr_jobs;
+
+	threads = calloc(nr_workers, sizeof(pthread_t));
+	if (!threads) {
+		fprintf(stderr, "Not enough memory\n");
+		return 1;
+	}
+
+	if (!stats) {
+		printf("Formatting %u devices (%u in parallel)\n",
+		       batch->nr_jobs, nr_workers);
+		fflush(stdout);
+	}
+
+	start = zonefs_usec();
+	for (nr_threads = 0; nr_threads < nr_workers; nr_threads++) {
+		ret = pthread_create(&threads[nr_threads], NULL,
+				     mkzonefs_job_worker, batch);
+		if (ret) {
+			fprintf(stderr, "Create thread failed %d (%s)\n",
+				ret, strerror(ret));
+			break;
+		}
+	}
+
+	/* Format the remaining devices if no thread could be started */
+	if (!nr_threads)
+		mkzonefs_job_worker(batch);
+
+	for (i = 0; i < nr_threads; i++)
+		pthread_join(threads[i], NULL);
+	elapsed = zonefs_usec() - start;
+
+	free(threads);
+
+	if (stats) {
+		printf("{\n");
+		printf("  \"version\": \"%s\",\n", PACKAGE_VERSION);
+		printf("  \"total_usec\": %llu,\n", elapsed);
+		printf("  \"devices\": [\n");
+		for (i = 0; i < batch->nr_jobs; i++) {
+			job = &batch->jobs[i];
+			if (job->ret)
+				nr_failed++;
+			mkzonefs_print_job_stats(job, i == batch->nr_jobs - 1);
+		}
+		printf("  ]\n");
+		printf("}\n");
+
+		return nr_failed ? 1 : 0;
+	}
+
+	for (i = 0; i < batch->nr_jobs; i++) {
+		job = &batch->jobs[i];
+		if (job->out && job->out_size)
+			fwrite(job->out, 1, job->out_size, stdout);
+	}
+
+	printf("Summary:\n");
+	for (i = 0; i < batch->nr_jobs; i++) {
+		job = &batch->jobs[i];
+		if (job->ret)
+			nr_failed++;
+		printf("  %s: %s, %llu.%03llu s\n",
+		       job->dev_path, job->ret ? "FAILED" : "OK",
+		       job->elapsed / 1000000,
+		       (job->elapsed % 1000000) / 1000);
+	}
+	printf("  %u devices formatted, %u failed, total time %llu.%03llu s\n",
+	       batch->nr_jobs - nr_failed, nr_failed,
+	       elapsed / 1000000, (elapsed % 1000000) / 1000);
+
+	return nr_failed ? 1 : 0;
+}
+
+static void mkzonefs_free_batch(struct mkzonefs_batch *batch)
+{
+	unsigned int i;
+
+	for (i = 0; i < batch->nr_jobs; i++) {
+		free(batch->jobs[i].dev_path);
+		free(batch->jobs[i].out);
+	}
+	free(batch->jobs);
+}
+
 /*
  * Main function.
  */
 int main(int argc, char **argv)
 {
-	unsigned int nr_zones;
+	struct mkzonefs_batch batch;
+	unsigned int nr_dev_workers = 0, nr_dev_args = 0;
+	char *list_path = NULL;
 	struct zonefs_dev dev;
-	char uuid_str[UUID_STR_LEN];
+	bool stats = false;
+	char **dev_args;
 	int i, ret;
 
 	/* Compile time checks */
 	ZONEFS_STATIC_ASSERT(sizeof(struct zonefs_super) == ZONEFS_SUPER_SIZE);
 	ZONEFS_STATIC_ASSERT(sizeof(uuid_t) == ZONEFS_UUID_SIZE);
 
-	/* Initialize */
-	memset(&dev, 0, sizeof(dev));
-	dev.fd = -1;
+	/* Initialize with defaults */
+	zonefs_init_dev(&dev, NULL);
+	memset(&batch, 0, sizeof(batch));
 
-	/* Defaults */
-	dev.uid = 0;	/* root */
-	dev.gid = 0; /* root */
-	dev.perm = S_IRUSR | S_IWUSR | S_IRGRP; /* 0640 */
+	dev_args = calloc(argc, sizeof(char *));
+	if (!dev_args) {
+		fprintf(stderr, "Not enough memory\n");
+		return 1;
+	}
 
 	/* Parse options */
 	for (i = 1; i < argc; i++) {
@@ -188,9 +651,15 @@ int main(int argc, char **argv)
 			dev.flags |= ZONEFS_OVERWRITE;
 		} else if (strcmp(argv[i], "-v") == 0) {
 			dev.flags |= ZONEFS_VERBOSE;
+		} else if (strcmp(argv[i], "-i") == 0) {
+			dev.flags |= ZONEFS_INCREMENTAL;
+		} else if (strcmp(argv[i], "-n") == 0) {
+			dev.flags |= ZONEFS_DRY_RUN;
+		} else if (strcmp(argv[i], "--stats") == 0) {
+			stats = true;
 		} else if (strcmp(argv[i], "-L") == 0) {
 			i++;
-			if (i >= argc - 1) {
+			if (i >= argc) {
 				fprintf(stderr, "Invalid command line\n");
 				return 1;
 			}
@@ -201,9 +670,70 @@ int main(int argc, char **argv)
 				return 1;
 			}
 			memcpy(dev.label, argv[i], strlen(argv[i]));
+		} else if (strcmp(argv[i], "-j") == 0) {
+			i++;
+			if (i >= argc) {
+				fprintf(stderr, "Invalid command line\n");
+				return 1;
+			}
+			ret = atoi(argv[i]);
+			if (ret <= 0 || ret > ZONEFS_MAX_WORKERS) {
+				fprintf(stderr,
+					"Invalid number of threads (1 to %d)\n",
+					ZONEFS_MAX_WORKERS);
+				return 1;
+			}
+			dev.nr_workers = ret;
+		} else if (strcmp(argv[i], "-D") == 0) {
+			i++;
+			if (i >= argc) {
+				fprintf(stderr, "Invalid command line\n");
+				return 1;
+			}
+			list_path = argv[i];
+		} else if (strcmp(argv[i], "-P") == 0) {
+			i++;
+			if (i >= argc) {
+				fprintf(stderr, "Invalid command line\n");
+				return 1;
+			}
+			ret = atoi(argv[i]);
+			if (ret <= 0) {
+				fprintf(stderr,
+					"Invalid number of parallel devices\n");
+				return 1;
+			}
+			nr_dev_workers = ret;
+		} else if (strcmp(argv[i], "-w") == 0) {
+			i++;
+			if (i >= argc) {
+				fprintf(stderr, "Invalid command line\n");
+				return 1;
+			}
+			if (strcmp(argv[i], "zero") == 0) {
+				dev.wipe = ZONEFS_WIPE_ZERO;
+			} else if (strcmp(argv[i], "discard") == 0) {
+				dev.wipe = ZONEFS_WIPE_DISCARD;
+			} else {
+				fprintf(stderr,
+					"Invalid wipe mode '%s'\n", argv[i]);
+				return 1;
+			}
+		} else if (strcmp(argv[i], "-B") == 0) {
+			i++;
+			if (i >= argc) {
+				fprintf(stderr, "Invalid command line\n");
+				return 1;
+			}
+			ret = atoi(argv[i]);
+			if (ret <= 0) {
+				fprintf(stderr, "Invalid wipe bandwidth\n");
+				return 1;
+			}
+			dev.wipe_bw = (unsigned long long)ret * 1024 * 1024;
 		} else if (strcmp(argv[i], "-o") == 0) {
 			i++;
-			if (i >= argc - 1) {
+			if (i >= argc) {
 				fprintf(stderr, "Invalid command line\n");
 				return 1;
 			}
@@ -213,89 +743,50 @@ int main(int argc, char **argv)
 			fprintf(stderr, "Invalid option '%s'\n", argv[i]);
 			return 1;
 		} else {
-			break;
+			dev_args[nr_dev_args++] = argv[i];
 		}
 	}
 
-	if (i != argc - 1) {
-		fprintf(stderr, "No device specified\n");
-		return 1;
-	}
-
-	/* Get device path */
-	dev.path = realpath(argv[i], NULL);
-	if (!dev.path) {
-		fprintf(stderr, "Failed to get device real path\n");
+	if (stats && (dev.flags & (ZONEFS_VERBOSE | ZONEFS_DRY_RUN))) {
+		fprintf(stderr,
+			"--stats cannot be used together with -v or -n\n");
 		return 1;
 	}
 
-	/* Open the device */
-	if (zonefs_open_dev(&dev, true) < 0)
+	if (dev.wipe_bw && dev.wipe == ZONEFS_WIPE_NONE) {
+		fprintf(stderr, "-B can only be used together with -w\n");
 		return 1;
-
-	printf("%s: %llu 512-byte sectors (%llu GiB)\n",
-	       dev.path,
-	       dev.capacity,
-	       (dev.capacity << 9) / (1024ULL * 1024ULL * 1024ULL));
-	printf("  Host-%s device\n",
-	       (dev.model == ZONEFS_DEV_HM) ? "managed" : "aware");
-	nr_zones = dev.capacity / dev.zone_nr_sectors;
-	printf("  %u zones of %zu 512-byte sectors (%zu MiB)\n",
-	       nr_zones,
-	       dev.zone_nr_sectors,
-	       (dev.zone_nr_sectors << 9) / (1024 * 1024));
-	if (nr_zones < dev.nr_zones) {
-		size_t runt_sectors = dev.capacity & (dev.zone_nr_sectors - 1);
-
-		printf("  1 runt zone of %zu 512-byte sectors (%zu MiB)\n",
-		       runt_sectors,
-		       (runt_sectors << 9) / (1024 * 1024));
-	}
-	printf("  %u conventional zones, %u sequential zones\n",
-	       dev.nr_conv_zones, dev.nr_seq_zones);
-	printf("  %u read-only zones, %u offline zones\n",
-	       dev.nr_ro_zones, dev.nr_ol_zones);
-
-	if (dev.nr_ol_zones >= dev.nr_zones - 1) {
-		fprintf(stderr, "No useable zones\n");
-		ret = 1;
-		goto out;
 	}
 
-	printf("Format:\n");
-	printf("  %u usable zones\n", dev.nr_zones - dev.nr_ol_zones - 1);
-	printf("  Aggregate conventional zones: %s\n",
-	       dev.features & ZONEFS_F_AGGRCNV ? "enabled" : "disabled");
-	printf("  File UID: %u\n", dev.uid);
-	printf("  File GID: %u\n", dev.gid);
-	printf("  File access permissions: %o\n", dev.perm);
-
-	if (strlen(dev.label))
-		printf("  FS label: %s\n", dev.label);
-
-	uuid_generate(dev.uuid);
-	uuid_unparse(dev.uuid, uuid_str);
-	printf("  FS UUID: %s\n", uuid_str);
-
+	/* Get the devices to format */
 	ret = 1;
+	for (i = 0; i < (int)nr_dev_args; i++) {
+		if (mkzonefs_add_job(&batch, &dev, dev_args[i]) < 0)
+			goto out;
+	}
 
-	printf("Resetting sequential zones\n");
-	if (zonefs_reset_zones(&dev) < 0)
+	if (list_path && mkzonefs_add_job_list(&batch, &dev, list_path) < 0)
 		goto out;
 
-	printf("Writing super block\n");
-	if (zonefs_write_super(&dev) < 0)
+	if (!batch.nr_jobs) {
+		fprintf(stderr, "No device specified\n");
 		goto out;
+	}
 
-	/* Sync */
-	if (zonefs_sync_dev(&dev) < 0)
+	/* Single device: no need for threads and buffered output */
+	if (batch.nr_jobs == 1 && !stats) {
+		if (isatty(STDOUT_FILENO))
+			batch.jobs[0].dev.flags |= ZONEFS_PROGRESS;
+		ret = mkzonefs_format(&batch.jobs[0].dev,
+				      batch.jobs[0].dev_path, stdout);
 		goto out;
+	}
 
-	ret = 0;
+	ret = mkzonefs_run_batch(&batch, nr_dev_workers, stats);
 
 out:
-	zonefs_close_dev(&dev);
+	mkzonefs_free_batch(&batch);
+	free(dev_args);
 
 	return ret;
 }
-
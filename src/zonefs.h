@@ -8,11 +8,8 @@
 #ifndef ZONEFS_H
 #define ZONEFS_H
 
-#define _LARGEFILE64_SOURCE
-
-#include "config.h"
-
 #include <limits.h>
+#include <stdio.h>
 #include <sys/types.h>
 #include <linux/blkzoned.h>
 #include <linux/magic.h>
@@ -74,8 +71,69 @@ struct zonefs_super {
 
 } __attribute__ ((packed));
 
+/*
+ * Zone table. To limit memory usage and improve cache locality with devices
+ * that have a large number of zones, zone information is stored as arrays
+ * instead of an array of struct blk_zone: the start sector of a zone is
+ * given by the zone number and the zone write pointer is stored as an
+ * offset from the zone start. This uses 6 bytes per zone instead of the
+ * 64 bytes of struct blk_zone.
+ */
+struct zonefs_zones {
+	__u32			*wp_ofst;
+	__u8			*type;
+	__u8			*cond;
+};
+
+/*
+ * Format phases.
+ */
+enum zonefs_phase {
+	ZONEFS_PHASE_MOUNT_CHECK,	/* Check if the device is mounted */
+	ZONEFS_PHASE_BUSY_CHECK,	/* Check if the device is in use */
+	ZONEFS_PHASE_PROBE,		/* Probe for existing content */
+	ZONEFS_PHASE_DEV_INFO,		/* Get the device zone model and size */
+	ZONEFS_PHASE_ZONE_REPORT,	/* Get the device zones */
+	ZONEFS_PHASE_ZONE_RESET,	/* Reset zones */
+	ZONEFS_PHASE_CNV_WIPE,		/* Wipe conventional zones */
+	ZONEFS_PHASE_SUPER,		/* Write the super block */
+	ZONEFS_PHASE_SYNC,		/* Sync the device and notify udev */
+
+	ZONEFS_NR_PHASES
+};
+
+/*
+ * Device statistics.
+ */
+struct zonefs_stats {
+
+	/* Time spent in each phase */
+	unsigned long long	phase_usec[ZONEFS_NR_PHASES];
+
+	/* Time counted in more than one phase running concurrently */
+	unsigned long long	overlap_usec;
+
+	/* Number of ioctls issued */
+	unsigned long long	nr_report_ioctls;
+	unsigned long long	nr_reset_ioctls;
+	unsigned long long	nr_finish_ioctls;
+	unsigned long long	nr_wipe_ioctls;
+	unsigned long long	nr_other_ioctls;
+
+};
+
+/*
+ * Maximum length of a library call error message.
+ */
+#define ZONEFS_ERRMSG_LEN	256
+
 /*
  * Device descriptor.
+ *
+ * The libzonefs ABI is not stable: the layout of this structure and of the
+ * structures it contains, which the zone table accessors below compile into
+ * applications, may change with any release. Applications must be rebuilt
+ * against the header of the installed library.
  */
 struct zonefs_dev {
 
@@ -92,6 +150,13 @@ struct zonefs_dev {
 	char			label[ZONEFS_LABEL_LEN];
 	uuid_t			uuid;
 
+	/* Number of threads to use for zone operations (0 means auto) */
+	unsigned int		nr_workers;
+
+	/* Conventional zones wipe mode and bandwidth limit (0 means none) */
+	unsigned int		wipe;
+	unsigned long long	wipe_bw;
+
 	/* Device info */
 	unsigned int		model;
 	unsigned long long	capacity;
@@ -101,11 +166,21 @@ struct zonefs_dev {
 	unsigned int		nr_seq_zones;
 	unsigned int		nr_ro_zones;
 	unsigned int		nr_ol_zones;
-	struct blk_zone		*zones;
+	struct zonefs_zones	zones;
 
 	/* Device file descriptor */
 	int			fd;
 
+	/* Stream of the zone, plan and progress messages (default: stdout) */
+	FILE			*out;
+
+	/* Statistics */
+	struct zonefs_stats	stats;
+
+	/* First error of the last failed library call */
+	int			err;
+	char			errmsg[ZONEFS_ERRMSG_LEN];
+
 };
 
 /*
@@ -119,20 +194,79 @@ struct zonefs_dev {
  */
 #define ZONEFS_VERBOSE  	(1 << 0)
 #define ZONEFS_OVERWRITE	(1 << 1)
+#define ZONEFS_INCREMENTAL	(1 << 2)
+#define ZONEFS_DRY_RUN		(1 << 3)
+#define ZONEFS_PROGRESS		(1 << 4)
+
+/*
+ * Conventional zones wipe modes.
+ */
+#define ZONEFS_WIPE_NONE	0
+#define ZONEFS_WIPE_ZERO	1
+#define ZONEFS_WIPE_DISCARD	2
+
+/*
+ * Zone table accessors.
+ */
+static inline __u64 zonefs_zone_start(struct zonefs_dev *dev,
+				      unsigned int zno)
+{
+	return (__u64)zno * dev->zone_nr_sectors;
+}
+
+static inline __u64 zonefs_zone_len(struct zonefs_dev *dev, unsigned int zno)
+{
+	__u64 start = zonefs_zone_start(dev, zno);
 
-#define zonefs_zone_id(dev, z) \
-	(unsigned int)((z)->start / (dev)->zone_nr_sectors)
+	if (start + dev->zone_nr_sectors > dev->capacity)
+		return dev->capacity - start;
+	return dev->zone_nr_sectors;
+}
 
+static inline __u64 zonefs_zone_wp(struct zonefs_dev *dev, unsigned int zno)
+{
+	return zonefs_zone_start(dev, zno) + dev->zones.wp_ofst[zno];
+}
+
+static inline unsigned int zonefs_zone_type(struct zonefs_dev *dev,
+					    unsigned int zno)
+{
+	return dev->zones.type[zno];
+}
+
+static inline bool zonefs_zone_is_conv(struct zonefs_dev *dev,
+				       unsigned int zno)
+{
+	return dev->zones.type[zno] == BLK_ZONE_TYPE_CONVENTIONAL;
+}
+
+static inline unsigned int zonefs_zone_cond(struct zonefs_dev *dev,
+					    unsigned int zno)
+{
+	return dev->zones.cond[zno];
+}
+
+void zonefs_init_dev(struct zonefs_dev *dev, char *path);
 int zonefs_open_dev(struct zonefs_dev *dev, bool check_overwrite);
+bool zonefs_dev_pipelined(struct zonefs_dev *dev);
+int zonefs_open_reset_dev(struct zonefs_dev *dev, bool check_overwrite);
 void zonefs_close_dev(struct zonefs_dev *dev);
 int zonefs_sync_dev(struct zonefs_dev *dev);
-int zonefs_finish_zone(struct zonefs_dev *dev, struct blk_zone *zone);
+int zonefs_refresh_zones(struct zonefs_dev *dev, unsigned int zno,
+			 unsigned int nr_zones);
+int zonefs_finish_zone(struct zonefs_dev *dev, unsigned int zno);
 int zonefs_reset_zones(struct zonefs_dev *dev);
+int zonefs_wipe_cnv_zones(struct zonefs_dev *dev);
+
+__u32 zonefs_crc32(__u32 crc, const void *buf, size_t length);
+int zonefs_write_super(struct zonefs_dev *dev);
 
 /*
- * For compile time checks
+ * Library calls returning an error do not print anything. The error number
+ * and message of the first error of the last failed call are returned by
+ * these functions. zonefs_dev_error() returns NULL if there is no error.
  */
-#define ZONEFS_STATIC_ASSERT(cond) \
-	void zonefs_static_assert(int dummy[(cond) ? 1 : -1])
+int zonefs_dev_errno(struct zonefs_dev *dev);
+const char *zonefs_dev_error(struct zonefs_dev *dev);
 
 #endif /* ZONEFS_H */
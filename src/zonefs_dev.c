@@ -6,15 +6,18 @@
  * Authors: Damien Le Moal (damien.lemoal@wdc.com)
  */
 
-#include "zonefs.h"
+#include "config.h"
+#include "zonefs_priv.h"
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include <unistd.h>
 #include <string.h>
 #include <errno.h>
 #include <libgen.h>
 #include <assert.h>
+#include <pthread.h>
 
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -26,6 +29,52 @@
 
 #include <blkid/blkid.h>
 
+/*
+ * Count ioctls for statistics. This may be called from multiple threads.
+ */
+#define zonefs_count_ioctl(dev, counter) \
+	__atomic_fetch_add(&(dev)->stats.counter, 1, __ATOMIC_RELAXED)
+
+/*
+ * Record an error of a library call. Only the first error is recorded as
+ * the following ones are usually a consequence of it. This may be called
+ * from multiple threads.
+ */
+void zonefs_set_error(struct zonefs_dev *dev, int err, const char *fmt, ...)
+{
+	int expected = 0;
+	va_list ap;
+
+	if (!err)
+		err = EIO;
+	if (!__atomic_compare_exchange_n(&dev->err, &expected, err, false,
+					 __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+		return;
+
+	va_start(ap, fmt);
+	vsnprintf(dev->errmsg, sizeof(dev->errmsg), fmt, ap);
+	va_end(ap);
+}
+
+/*
+ * Error code of the last failed library call, 0 if none.
+ */
+int zonefs_dev_errno(struct zonefs_dev *dev)
+{
+	return __atomic_load_n(&dev->err, __ATOMIC_ACQUIRE);
+}
+
+/*
+ * Error message of the last failed library call, NULL if none.
+ */
+const char *zonefs_dev_error(struct zonefs_dev *dev)
+{
+	if (!zonefs_dev_errno(dev))
+		return NULL;
+
+	return dev->errmsg;
+}
+
 /*
  * Test if the device is mounted.
  */
@@ -62,7 +111,7 @@ static int zonefs_dev_busy(struct zonefs_dev *dev)
 
 	n = scandir(path, &namelist, NULL, alphasort);
 	if (n < 0) {
-		fprintf(stderr, "scandir %s failed\n", path);
+		zonefs_set_error(dev, errno, "scandir %s failed", path);
 		return -1;
 	}
 
@@ -92,11 +141,8 @@ static bool zonefs_dev_has_reset_all(struct zonefs_dev *dev)
 	len = snprintf(path, sizeof(path),
 		       "/sys/block/%s/dm/name",
 		       dev->name);
-	if (len >= PATH_MAX) {
-		fprintf(stderr, "name %s failed: %s\n", path,
-			strerror(ENAMETOOLONG));
+	if (len >= PATH_MAX)
 		return false;
-	}
 
 	return stat(path, &st) != 0;
 }
@@ -118,14 +164,14 @@ static bool zonefs_dev_is_zoned(struct zonefs_dev *dev)
 
 	/* Indicates truncation */
 	if (len >= PATH_MAX) {
-		fprintf(stderr, "name %s failed: %s\n", str,
+		zonefs_set_error(dev, ENAMETOOLONG, "name %s failed: %s", str,
 			strerror(ENAMETOOLONG));
 		return false;
 	}
 
 	file = fopen(str, "r");
 	if (!file) {
-		fprintf(stderr, "Open %s failed\n", str);
+		zonefs_set_error(dev, errno, "Open %s failed", str);
 		return false;
 	}
 
@@ -134,7 +180,7 @@ static bool zonefs_dev_is_zoned(struct zonefs_dev *dev)
 	fclose(file);
 
 	if (res != 1) {
-		fprintf(stderr, "Invalid file %s format\n", str);
+		zonefs_set_error(dev, EINVAL, "Invalid file %s format", str);
 		return false;
 	}
 
@@ -161,9 +207,10 @@ static int zonefs_get_dev_capacity(struct zonefs_dev *dev)
 	int res;
 
 	/* Get capacity */
+	zonefs_count_ioctl(dev, nr_other_ioctls);
 	if (ioctl(dev->fd, BLKGETSIZE64, &dev->capacity) < 0) {
-		fprintf(stderr,
-			"%s: Get capacity failed %d (%s)\n",
+		zonefs_set_error(dev, errno,
+			"%s: Get capacity failed %d (%s)",
 			dev->path, errno, strerror(errno));
 		return -1;
 	}
@@ -175,7 +222,7 @@ static int zonefs_get_dev_capacity(struct zonefs_dev *dev)
 		 dev->name);
 	file = fopen(str, "r");
 	if (!file) {
-		fprintf(stderr, "Open %s failed\n", str);
+		zonefs_set_error(dev, errno, "Open %s failed", str);
 		return -1;
 	}
 
@@ -184,14 +231,14 @@ static int zonefs_get_dev_capacity(struct zonefs_dev *dev)
 	fclose(file);
 
 	if (res != 1) {
-		fprintf(stderr, "Invalid file %s format\n", str);
+		zonefs_set_error(dev, EINVAL, "Invalid file %s format", str);
 		return -1;
 	}
 
 	dev->zone_nr_sectors = atol(str);
-	if (!dev->zone_nr_sectors) {
-		fprintf(stderr,
-			"%s: Invalid zone size\n",
+	if (!dev->zone_nr_sectors || dev->zone_nr_sectors > UINT_MAX) {
+		zonefs_set_error(dev, EINVAL,
+			"%s: Invalid zone size",
 			dev->path);
 		return -1;
 	}
@@ -202,9 +249,9 @@ static int zonefs_get_dev_capacity(struct zonefs_dev *dev)
 /*
  * Convert zone type to a string.
  */
-static inline const char *zonefs_zone_type_str(struct blk_zone *zone)
+static inline const char *zonefs_zone_type_str(unsigned int type)
 {
-	switch (zone->type) {
+	switch (type) {
 	case BLK_ZONE_TYPE_CONVENTIONAL:
 		return( "Conventional" );
 	case BLK_ZONE_TYPE_SEQWRITE_REQ:
@@ -218,9 +265,9 @@ static inline const char *zonefs_zone_type_str(struct blk_zone *zone)
 /*
  * Convert zone condition to a string.
  */
-static inline const char *zonefs_zone_cond_str(struct blk_zone *zone)
+static inline const char *zonefs_zone_cond_str(unsigned int cond)
 {
-	switch (zone->cond) {
+	switch (cond) {
 	case BLK_ZONE_COND_NOT_WP:
 		return "Not-write-pointer";
 	case BLK_ZONE_COND_EMPTY:
@@ -244,85 +291,258 @@ static inline const char *zonefs_zone_cond_str(struct blk_zone *zone)
 /*
  * Print a device zone information.
  */
-static void zonefs_print_zone(struct zonefs_dev *dev, struct blk_zone *zone)
+static void zonefs_print_zone(struct zonefs_dev *dev, unsigned int zno)
 {
+	unsigned int type = zonefs_zone_type(dev, zno);
+	unsigned int cond = zonefs_zone_cond(dev, zno);
 
-	if (zone->cond == BLK_ZONE_COND_READONLY) {
-		printf("Zone %05u: readonly %s zone\n",
-		       zonefs_zone_id(dev, zone),
-		       zonefs_zone_type_str(zone));
+	if (cond == BLK_ZONE_COND_READONLY) {
+		fprintf(dev->out, "Zone %05u: readonly %s zone\n",
+			zno, zonefs_zone_type_str(type));
 		return;
 	}
 
-	if (zone->cond == BLK_ZONE_COND_OFFLINE) {
-		printf("Zone %05u: offline %s zone\n",
-		       zonefs_zone_id(dev, zone),
-		       zonefs_zone_type_str(zone));
+	if (cond == BLK_ZONE_COND_OFFLINE) {
+		fprintf(dev->out, "Zone %05u: offline %s zone\n",
+			zno, zonefs_zone_type_str(type));
 		return;
 	}
 
-	if (zone->type == BLK_ZONE_TYPE_CONVENTIONAL) {
-		printf("Zone %05u: Conventional, sector %llu, %llu sectors\n",
-		       zonefs_zone_id(dev, zone),
-		       zone->start, zone->len);
+	if (type == BLK_ZONE_TYPE_CONVENTIONAL) {
+		fprintf(dev->out,
+			"Zone %05u: Conventional, sector %llu, %llu sectors\n",
+			zno,
+			zonefs_zone_start(dev, zno), zonefs_zone_len(dev, zno));
 		return;
 	}
 
-	printf("Zone %05u: type 0x%x (%s), cond 0x%x (%s), "
-	       "sector %llu, %llu sectors, wp sector %llu\n",
-	       zonefs_zone_id(dev, zone),
-	       zone->type, zonefs_zone_type_str(zone),
-	       zone->cond, zonefs_zone_cond_str(zone),
-	       zone->start, zone->len, zone->wp);
+	fprintf(dev->out, "Zone %05u: type 0x%x (%s), cond 0x%x (%s), "
+		"sector %llu, %llu sectors, wp sector %llu\n",
+		zno,
+		type, zonefs_zone_type_str(type),
+		cond, zonefs_zone_cond_str(cond),
+		zonefs_zone_start(dev, zno), zonefs_zone_len(dev, zno),
+		zonefs_zone_wp(dev, zno));
+}
+
+/*
+ * Get the number of threads to use for processing nr_zones zones.
+ */
+static unsigned int zonefs_nr_workers(struct zonefs_dev *dev,
+				      unsigned int nr_zones)
+{
+	unsigned int nr_workers = dev->nr_workers;
+	long nr_cpus;
+
+	if (!nr_workers) {
+		nr_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		nr_workers = nr_cpus > 0 ? nr_cpus : 1;
+	}
+
+	if (nr_workers > ZONEFS_MAX_WORKERS)
+		nr_workers = ZONEFS_MAX_WORKERS;
+	if (nr_workers > nr_zones)
+		nr_workers = nr_zones;
+	if (!nr_workers)
+		nr_workers = 1;
+
+	return nr_workers;
+}
+
+/*
+ * A device is usable if it has at least one zone that is not offline in
+ * addition to the super block zone.
+ */
+static bool zonefs_dev_usable(struct zonefs_dev *dev)
+{
+	return dev->nr_ol_zones < dev->nr_zones - 1;
+}
+
+/*
+ * Format pipeline. When formatting a device, the zone report streams
+ * batches of reported zones to the zone reset workers, and the zone reset
+ * workers process these batches while the zone report continues. The
+ * existing content probe runs concurrently with the zone report. No zone
+ * is reset until the probe completes and allows overwriting the device
+ * content, and until the zone report shows that the device is usable.
+ */
+#define ZONEFS_PIPE_BATCH_ZONES		128
+
+struct zonefs_pipe_batch {
+	unsigned int			zno;
+	unsigned int			nr_zones;
+	struct zonefs_pipe_batch	*next;
+};
+
+struct zonefs_pipe {
+	struct zonefs_dev	*dev;
+
+	pthread_mutex_t		lock;
+	pthread_cond_t		cond;
+
+	/* Existing content probe gate */
+	bool			probe_done;
+
+	/* Batches of reported zones waiting to be processed */
+	struct zonefs_pipe_batch *head;
+	struct zonefs_pipe_batch *tail;
+	bool			report_done;
+
+	/* Usable device gate: number of reported zones not offline */
+	unsigned int		nr_usable;
+
+	/* Reset workers */
+	unsigned int		nr_running;
+	unsigned int		nr_done;
+	int			error;
+};
+
+/*
+ * Queue reported zones for processing by the reset workers, splitting them
+ * into batches of at most ZONEFS_PIPE_BATCH_ZONES zones.
+ */
+static int zonefs_pipe_push(struct zonefs_pipe *pipe,
+			    unsigned int zno, unsigned int nr_zones)
+{
+	struct zonefs_pipe_batch *b;
+	unsigned int i, n, nr_usable;
+
+	while (nr_zones) {
+		n = nr_zones;
+		if (n > ZONEFS_PIPE_BATCH_ZONES)
+			n = ZONEFS_PIPE_BATCH_ZONES;
+
+		nr_usable = 0;
+		for (i = zno; i < zno + n; i++) {
+			if (zonefs_zone_cond(pipe->dev, i) !=
+			    BLK_ZONE_COND_OFFLINE)
+				nr_usable++;
+		}
+
+		b = malloc(sizeof(struct zonefs_pipe_batch));
+		if (!b) {
+			zonefs_set_error(pipe->dev, ENOMEM,
+					 "Not enough memory");
+			return -1;
+		}
+		b->zno = zno;
+		b->nr_zones = n;
+		b->next = NULL;
+
+		pthread_mutex_lock(&pipe->lock);
+		if (pipe->tail)
+			pipe->tail->next = b;
+		else
+			pipe->head = b;
+		pipe->tail = b;
+		pipe->nr_usable += nr_usable;
+		pthread_cond_broadcast(&pipe->cond);
+		pthread_mutex_unlock(&pipe->lock);
+
+		zno += n;
+		nr_zones -= n;
+	}
+
+	return 0;
+}
+
+/*
+ * Abort a pipeline.
+ */
+static void zonefs_pipe_abort(struct zonefs_pipe *pipe)
+{
+	pthread_mutex_lock(&pipe->lock);
+	pipe->error = 1;
+	pthread_cond_broadcast(&pipe->cond);
+	pthread_mutex_unlock(&pipe->lock);
+}
+
+static bool zonefs_pipe_aborted(struct zonefs_pipe *pipe)
+{
+	bool aborted;
+
+	pthread_mutex_lock(&pipe->lock);
+	aborted = pipe->error;
+	pthread_mutex_unlock(&pipe->lock);
+
+	return aborted;
 }
 
+/*
+ * Maximum zone report buffer size and minimum number of zones per zone
+ * report thread.
+ */
 #define ZONEFS_REPORT_ZONES_BUFSZ	524288
+#define ZONEFS_REPORT_SHARD_MIN_ZONES	1024
 
 /*
- * Get a device zone configuration.
+ * Zone report shard: a range of zones reported by a single thread into its
+ * own slice of the device zone array.
  */
-static int zonefs_get_dev_zones(struct zonefs_dev *dev)
+struct zonefs_report_shard {
+	struct zonefs_dev	*dev;
+	struct zonefs_pipe	*pipe;
+	unsigned int		zno;
+	unsigned int		nr_zones;
+
+	/* Shard results */
+	unsigned int		nr_reported;
+	unsigned int		nr_conv_zones;
+	unsigned int		nr_seq_zones;
+	unsigned int		nr_ro_zones;
+	unsigned int		nr_ol_zones;
+	int			ret;
+};
+
+/*
+ * Get the zone configuration for the range of zones of a shard.
+ */
+static int zonefs_report_shard(struct zonefs_report_shard *sh)
 {
+	struct zonefs_dev *dev = sh->dev;
 	struct blk_zone_report *rep = NULL;
 	unsigned int rep_max_zones;
 	struct blk_zone *blkz;
-	unsigned int i, nr_zones;
-	__u64 sector;
+	__u64 sector, end;
+	unsigned int i, zno, first;
+	size_t bufsz;
 	int ret = -1;
 
-	/* This will ignore an eventual last smaller zone */
-	nr_zones = dev->capacity / dev->zone_nr_sectors;
-	if (dev->capacity % dev->zone_nr_sectors)
-		nr_zones++;
-
-	/* Allocate zone array */
-	dev->zones = calloc(nr_zones, sizeof(struct blk_zone));
-	if (!dev->zones) {
-		fprintf(stderr, "Not enough memory\n");
-		return -1;
-	}
+	sector = (__u64)sh->zno * dev->zone_nr_sectors;
+	end = (__u64)(sh->zno + sh->nr_zones) * dev->zone_nr_sectors;
+	if (end > dev->capacity)
+		end = dev->capacity;
 
-	/* Get a buffer for zone report */
-	rep = malloc(ZONEFS_REPORT_ZONES_BUFSZ);
-	if (!rep) {
-		fprintf(stderr, "Not enough memory\n");
-		goto out;
-	}
+	/* Get a buffer for zone report, sized for the shard zones */
 	rep_max_zones =
 		(ZONEFS_REPORT_ZONES_BUFSZ - sizeof(struct blk_zone_report))
 		/ sizeof(struct blk_zone);
+	if (rep_max_zones > sh->nr_zones)
+		rep_max_zones = sh->nr_zones;
+	bufsz = sizeof(struct blk_zone_report) +
+		rep_max_zones * sizeof(struct blk_zone);
+	rep = malloc(bufsz);
+	if (!rep) {
+		zonefs_set_error(dev, ENOMEM, "Not enough memory");
+		goto out;
+	}
 
-	sector = 0;
-	while (sector < dev->capacity) {
+	while (sector < end) {
+
+		if (sh->pipe && zonefs_pipe_aborted(sh->pipe)) {
+			ret = -1;
+			goto out;
+		}
 
 		/* Get zone information */
-		memset(rep, 0, ZONEFS_REPORT_ZONES_BUFSZ);
+		memset(rep, 0, sizeof(struct blk_zone_report));
 		rep->sector = sector;
 		rep->nr_zones = rep_max_zones;
+		zonefs_count_ioctl(dev, nr_report_ioctls);
 		ret = ioctl(dev->fd, BLKREPORTZONE, rep);
 		if (ret != 0) {
-			fprintf(stderr,
-				"%s: Get zone information failed %d (%s)\n",
+			zonefs_set_error(dev, errno,
+				"%s: Get zone information failed %d (%s)",
 				dev->name, errno, strerror(errno));
 			goto out;
 		}
@@ -331,63 +551,262 @@ static int zonefs_get_dev_zones(struct zonefs_dev *dev)
 			break;
 
 		blkz = (struct blk_zone *)(rep + 1);
-		for (i = 0; i < rep->nr_zones && sector < dev->capacity; i++) {
-
-			if (dev->flags & ZONEFS_VERBOSE)
-				zonefs_print_zone(dev, blkz);
+		first = sh->zno + sh->nr_reported;
+		for (i = 0; i < rep->nr_zones && sector < end; i++) {
+
+			/* Check zone position */
+			if (blkz->start != sector ||
+			    sh->nr_reported >= sh->nr_zones) {
+				zonefs_set_error(dev, EINVAL,
+					"%s: Invalid zone %u start sector",
+					dev->name,
+					zonefs_zone_id(dev, blkz->start));
+				ret = -1;
+				goto out;
+			}
 
 			/* Check zone size */
 			if (blkz->len != dev->zone_nr_sectors &&
 			    blkz->start + blkz->len != dev->capacity) {
-				fprintf(stderr,
-					"%s: Invalid zone %u size\n",
+				zonefs_set_error(dev, EINVAL,
+					"%s: Invalid zone %u size",
 					dev->name,
-					zonefs_zone_id(dev, blkz));
+					zonefs_zone_id(dev, blkz->start));
 				ret = -1;
 				goto out;
 			}
 
-			dev->zones[dev->nr_zones] = *blkz;
-			dev->nr_zones++;
+			zno = sh->zno + sh->nr_reported;
+			dev->zones.type[zno] = blkz->type;
+			dev->zones.cond[zno] = blkz->cond;
+			if (blkz->wp >= blkz->start &&
+			    blkz->wp <= blkz->start + blkz->len)
+				zonefs_zone_set_wp(dev, zno, blkz->wp);
+			else
+				zonefs_zone_set_wp(dev, zno,
+						   blkz->start + blkz->len);
+			sh->nr_reported++;
 
 			if (blkz->cond == BLK_ZONE_COND_READONLY)
-				dev->nr_ro_zones++;
+				sh->nr_ro_zones++;
 			else if (blkz->cond == BLK_ZONE_COND_OFFLINE)
-				dev->nr_ol_zones++;
+				sh->nr_ol_zones++;
 
 			if (blkz->type == BLK_ZONE_TYPE_CONVENTIONAL)
-				dev->nr_conv_zones++;
+				sh->nr_conv_zones++;
 			else
-				dev->nr_seq_zones++;
+				sh->nr_seq_zones++;
 
 			sector = blkz->start + blkz->len;
 			blkz++;
 
 		}
 
+		/* Hand over the reported zones to the reset workers */
+		if (sh->pipe) {
+			ret = zonefs_pipe_push(sh->pipe, first,
+					sh->zno + sh->nr_reported - first);
+			if (ret)
+				goto out;
+		}
+
 	}
 
-	if (sector != dev->capacity) {
-		fprintf(stderr,
+	if (sector != end) {
+		zonefs_set_error(dev, EINVAL,
 			"%s: Invalid zones (last sector reported is %llu, "
-			"expected %llu)\n",
+			"expected %llu)",
 			dev->name,
-			sector, dev->capacity);
+			sector, end);
 		ret = -1;
 		goto out;
 	}
 
+	ret = 0;
+
+out:
+	free(rep);
+
+	return ret;
+}
+
+static void *zonefs_report_worker(void *arg)
+{
+	struct zonefs_report_shard *sh = arg;
+
+	sh->ret = zonefs_report_shard(sh);
+
+	return NULL;
+}
+
+/*
+ * Get a device zone configuration. For devices with a large number of zones,
+ * the zone report is split into shards processed by multiple threads.
+ * If pipe is not NULL, reported zones are handed over to the pipeline
+ * zone reset workers.
+ */
+static int zonefs_get_dev_zones(struct zonefs_dev *dev,
+				struct zonefs_pipe *pipe)
+{
+	struct zonefs_report_shard shards[ZONEFS_MAX_WORKERS];
+	pthread_t threads[ZONEFS_MAX_WORKERS];
+	unsigned int i, nr_zones, nr_shards, shard_zones;
+	struct zonefs_report_shard *sh;
+	int ret = 0;
+
+	/* This will ignore an eventual last smaller zone */
+	nr_zones = dev->capacity / dev->zone_nr_sectors;
+	if (dev->capacity % dev->zone_nr_sectors)
+		nr_zones++;
+	if (!nr_zones) {
+		zonefs_set_error(dev, EINVAL, "%s: No zones", dev->name);
+		return -1;
+	}
+
+	/* Allocate the zone table */
+	dev->zones.wp_ofst = calloc(nr_zones, sizeof(__u32));
+	dev->zones.type = calloc(nr_zones, sizeof(__u8));
+	dev->zones.cond = calloc(nr_zones, sizeof(__u8));
+	if (!dev->zones.wp_ofst || !dev->zones.type || !dev->zones.cond) {
+		zonefs_set_error(dev, ENOMEM, "Not enough memory");
+		return -1;
+	}
+
+	/* Split the zones into shards */
+	nr_shards = zonefs_nr_workers(dev,
+				nr_zones / ZONEFS_REPORT_SHARD_MIN_ZONES);
+	shard_zones = (nr_zones + nr_shards - 1) / nr_shards;
+	nr_shards = (nr_zones + shard_zones - 1) / shard_zones;
+
+	memset(shards, 0, sizeof(shards));
+	for (i = 0; i < nr_shards; i++) {
+		sh = &shards[i];
+		sh->dev = dev;
+		sh->pipe = pipe;
+		sh->zno = i * shard_zones;
+		sh->nr_zones = shard_zones;
+		if (sh->zno + sh->nr_zones > nr_zones)
+			sh->nr_zones = nr_zones - sh->zno;
+	}
+
+	if (nr_shards == 1) {
+		shards[0].ret = zonefs_report_shard(&shards[0]);
+	} else {
+		for (i = 0; i < nr_shards; i++) {
+			ret = pthread_create(&threads[i], NULL,
+					     zonefs_report_worker, &shards[i]);
+			if (ret) {
+				zonefs_set_error(dev, ret,
+					"%s: Create report thread failed %d (%s)",
+					dev->name, ret, strerror(ret));
+				shards[i].ret = -1;
+				break;
+			}
+		}
+		nr_shards = i;
+		for (i = 0; i < nr_shards; i++)
+			pthread_join(threads[i], NULL);
+		if (ret)
+			return -1;
+	}
+
+	/* Merge the shards results */
+	for (i = 0; i < nr_shards; i++) {
+		sh = &shards[i];
+		if (sh->ret)
+			return -1;
+		dev->nr_zones += sh->nr_reported;
+		dev->nr_conv_zones += sh->nr_conv_zones;
+		dev->nr_seq_zones += sh->nr_seq_zones;
+		dev->nr_ro_zones += sh->nr_ro_zones;
+		dev->nr_ol_zones += sh->nr_ol_zones;
+	}
+
 	if (dev->nr_zones != nr_zones) {
-		fprintf(stderr,
-			"%s: Invalid number of zones (expected %u, got %u)\n",
+		zonefs_set_error(dev, EINVAL,
+			"%s: Invalid number of zones (expected %u, got %u)",
 			dev->name,
 			nr_zones, dev->nr_zones);
-		ret = -1;
-		goto out;
+		return -1;
 	}
 
-out:
-	free(rep);
+	if (dev->flags & ZONEFS_VERBOSE) {
+		for (i = 0; i < dev->nr_zones; i++)
+			zonefs_print_zone(dev, i);
+	}
+
+	return 0;
+}
+
+/*
+ * Count the zones of a shard using the zone table.
+ */
+static void zonefs_count_zones(struct zonefs_report_shard *sh)
+{
+	struct zonefs_dev *dev = sh->dev;
+	unsigned int i, cond;
+
+	sh->nr_conv_zones = 0;
+	sh->nr_seq_zones = 0;
+	sh->nr_ro_zones = 0;
+	sh->nr_ol_zones = 0;
+
+	for (i = sh->zno; i < sh->zno + sh->nr_zones; i++) {
+		cond = zonefs_zone_cond(dev, i);
+		if (cond == BLK_ZONE_COND_READONLY)
+			sh->nr_ro_zones++;
+		else if (cond == BLK_ZONE_COND_OFFLINE)
+			sh->nr_ol_zones++;
+
+		if (zonefs_zone_is_conv(dev, i))
+			sh->nr_conv_zones++;
+		else
+			sh->nr_seq_zones++;
+	}
+}
+
+/*
+ * Refresh the zone table entries of the nr_zones zones starting from zone
+ * zno, updating the device zone counters accordingly.
+ */
+int zonefs_refresh_zones(struct zonefs_dev *dev, unsigned int zno,
+			 unsigned int nr_zones)
+{
+	struct zonefs_report_shard old, sh;
+	int ret;
+
+	zonefs_clear_error(dev);
+
+	if (zno >= dev->nr_zones || nr_zones > dev->nr_zones - zno) {
+		zonefs_set_error(dev, EINVAL,
+			"%s: Invalid zone range %u + %u",
+			dev->name, zno, nr_zones);
+		return -1;
+	}
+
+	if (!nr_zones)
+		return 0;
+
+	memset(&old, 0, sizeof(old));
+	old.dev = dev;
+	old.zno = zno;
+	old.nr_zones = nr_zones;
+	sh = old;
+
+	zonefs_count_zones(&old);
+	ret = zonefs_report_shard(&sh);
+
+	/* On error, the zone table may have been partially updated */
+	zonefs_count_zones(&sh);
+	dev->nr_conv_zones += sh.nr_conv_zones - old.nr_conv_zones;
+	dev->nr_seq_zones += sh.nr_seq_zones - old.nr_seq_zones;
+	dev->nr_ro_zones += sh.nr_ro_zones - old.nr_ro_zones;
+	dev->nr_ol_zones += sh.nr_ol_zones - old.nr_ol_zones;
+
+	if (!ret && (dev->flags & ZONEFS_VERBOSE)) {
+		for (; zno < sh.zno + nr_zones; zno++)
+			zonefs_print_zone(dev, zno);
+	}
 
 	return ret;
 }
@@ -397,22 +816,40 @@ out:
  */
 static int zonefs_get_dev_info(struct zonefs_dev *dev)
 {
+	unsigned long long start = zonefs_usec();
+	int ret;
+
 	if (!zonefs_dev_is_zoned(dev)) {
-		fprintf(stderr,
-			"%s: Not a zoned block device\n",
+		zonefs_set_error(dev, ENODEV,
+			"%s: Not a zoned block device",
 			dev->name);
 		return -1;
 	}
 
-	if (zonefs_get_dev_capacity(dev) < 0)
-		return -1;
-
-	if (zonefs_get_dev_zones(dev) < 0)
+	ret = zonefs_get_dev_capacity(dev);
+	zonefs_phase_done(dev, ZONEFS_PHASE_DEV_INFO, start);
+	if (ret < 0)
 		return -1;
 
 	return 0;
 }
 
+/*
+ * Get a device zone configuration, handing over the reported zones to the
+ * pipeline zone reset workers if pipe is not NULL.
+ */
+static int zonefs_report_dev_zones(struct zonefs_dev *dev,
+				   struct zonefs_pipe *pipe)
+{
+	unsigned long long start = zonefs_usec();
+	int ret;
+
+	ret = zonefs_get_dev_zones(dev, pipe);
+	zonefs_phase_done(dev, ZONEFS_PHASE_ZONE_REPORT, start);
+
+	return ret;
+}
+
 /*
  * Use libblkid to check for existing file systems on the device.
  * Return -1 on error, 0 if something valid is detected on the device
@@ -420,15 +857,23 @@ static int zonefs_get_dev_info(struct zonefs_dev *dev)
  */
 static int zonefs_check_overwrite(struct zonefs_dev *dev)
 {
+	blkid_probe pr = NULL;
 	const char *type;
-	blkid_probe pr;
-	int ret = -1;
+	int fd, ret = -1;
+
+	/*
+	 * Use a separate buffered file descriptor so that the probe can run
+	 * while the device file descriptor is used for the zone report.
+	 */
+	fd = open(dev->path, O_RDONLY);
+	if (fd < 0)
+		goto out;
 
 	pr = blkid_new_probe();
 	if (!pr)
 		goto out;
 
-	ret = blkid_probe_set_device(pr, dev->fd, 0, 0);
+	ret = blkid_probe_set_device(pr, fd, 0, 0);
 	if (ret < 0)
 		goto out;
 
@@ -449,44 +894,120 @@ static int zonefs_check_overwrite(struct zonefs_dev *dev)
 	/* Analyze what was found on the device */
 	ret = blkid_probe_lookup_value(pr, "TYPE", &type, NULL);
 	if (ret == 0) {
-		fprintf(stderr,
-			"%s appears to contain an existing filesystem (%s)\n",
+		zonefs_set_error(dev, EEXIST,
+			"%s appears to contain an existing filesystem (%s)",
 			dev->path, type);
 		goto out;
 	}
 
 	ret = blkid_probe_lookup_value(pr, "PTTYPE", &type, NULL);
 	if (ret == 0) {
-		fprintf(stderr,
-			"%s appears to contain a partition table (%s)\n",
+		zonefs_set_error(dev, EEXIST,
+			"%s appears to contain a partition table (%s)",
 			dev->path, type);
 		goto out;
 	}
 
-	fprintf(stderr,
-		"%s appears to contain something according to blkid\n",
+	zonefs_set_error(dev, EEXIST,
+		"%s appears to contain something according to blkid",
 		dev->path);
 	ret = 0;
 
 out:
 	if (pr)
 		blkid_free_probe(pr);
+	if (fd >= 0)
+		close(fd);
 
-	if (ret == 0)
-		fprintf(stderr, "Use the option '-f' to overwrite\n");
-	else if (ret < 0)
-		fprintf(stderr,
-			"%s: probe failed, cannot detect existing filesystem\n",
+	if (ret < 0)
+		zonefs_set_error(dev, EIO,
+			"%s: probe failed, cannot detect existing filesystem",
 			dev->name);
 
 	return ret;
 }
 
 /*
- * Open a device.
+ * Existing content probe, executed concurrently with the device zone report.
  */
-int zonefs_open_dev(struct zonefs_dev *dev, bool check_overwrite)
+struct zonefs_probe {
+	struct zonefs_dev	*dev;
+	struct zonefs_pipe	*pipe;
+	pthread_t		thread;
+	bool			async;
+	int			ret;
+};
+
+static void *zonefs_probe_worker(void *arg)
+{
+	struct zonefs_probe *probe = arg;
+	struct zonefs_dev *dev = probe->dev;
+	struct zonefs_pipe *pipe = probe->pipe;
+	unsigned long long start = zonefs_usec();
+
+	probe->ret = zonefs_check_overwrite(dev);
+	zonefs_phase_done(dev, ZONEFS_PHASE_PROBE, start);
+
+	/* Open the reset gate or abort the pipeline */
+	if (pipe) {
+		pthread_mutex_lock(&pipe->lock);
+		pipe->probe_done = true;
+		if (probe->ret <= 0)
+			pipe->error = 1;
+		pthread_cond_broadcast(&pipe->cond);
+		pthread_mutex_unlock(&pipe->lock);
+	}
+
+	return NULL;
+}
+
+/*
+ * Start the existing content probe, falling back to a synchronous probe
+ * if the probe thread cannot be created.
+ */
+static void zonefs_start_probe(struct zonefs_probe *probe)
 {
+	probe->async = pthread_create(&probe->thread, NULL,
+				      zonefs_probe_worker, probe) == 0;
+	if (!probe->async)
+		zonefs_probe_worker(probe);
+}
+
+/*
+ * Wait for the existing content probe to complete and return its result.
+ */
+static int zonefs_wait_probe(struct zonefs_probe *probe)
+{
+	if (probe->async) {
+		pthread_join(probe->thread, NULL);
+		probe->async = false;
+	}
+
+	return probe->ret;
+}
+
+/*
+ * Initialize a device descriptor with default values.
+ */
+void zonefs_init_dev(struct zonefs_dev *dev, char *path)
+{
+	memset(dev, 0, sizeof(*dev));
+	dev->path = path;
+	dev->fd = -1;
+	dev->out = stdout;
+
+	/* Defaults */
+	dev->uid = 0;	/* root */
+	dev->gid = 0; /* root */
+	dev->perm = S_IRUSR | S_IWUSR | S_IRGRP; /* 0640 */
+}
+
+/*
+ * Check that a device can be formatted and open it.
+ */
+static int zonefs_do_open_dev(struct zonefs_dev *dev)
+{
+	unsigned long long start;
 	struct stat st;
 	int ret;
 
@@ -494,30 +1015,36 @@ int zonefs_open_dev(struct zonefs_dev *dev, bool check_overwrite)
 
 	/* Check that this is a block device */
 	if (stat(dev->path, &st) < 0) {
-		fprintf(stderr,
-			"Get %s stat failed %d (%s)\n",
+		zonefs_set_error(dev, errno,
+			"Get %s stat failed %d (%s)",
 			dev->path,
 			errno, strerror(errno));
 		return -1;
 	}
 
 	if (!S_ISBLK(st.st_mode)) {
-		fprintf(stderr,
-			"%s is not a block device\n",
+		zonefs_set_error(dev, ENOTBLK,
+			"%s is not a block device",
 			dev->path);
 		return -1;
 	}
 
-	if (zonefs_dev_mounted(dev)) {
-		fprintf(stderr,
-			"%s is mounted\n",
+	start = zonefs_usec();
+	ret = zonefs_dev_mounted(dev);
+	zonefs_phase_done(dev, ZONEFS_PHASE_MOUNT_CHECK, start);
+	if (ret) {
+		zonefs_set_error(dev, EBUSY,
+			"%s is mounted",
 			dev->path);
 		return -1;
 	}
 
-	if (zonefs_dev_busy(dev)) {
-		fprintf(stderr,
-			"%s is in use\n",
+	start = zonefs_usec();
+	ret = zonefs_dev_busy(dev);
+	zonefs_phase_done(dev, ZONEFS_PHASE_BUSY_CHECK, start);
+	if (ret) {
+		zonefs_set_error(dev, EBUSY,
+			"%s is in use",
 			dev->path);
 		return -1;
 	}
@@ -525,38 +1052,54 @@ int zonefs_open_dev(struct zonefs_dev *dev, bool check_overwrite)
 	/* Open device */
 	dev->fd = open(dev->path, O_RDWR | O_EXCL);
 	if (dev->fd < 0) {
-		fprintf(stderr,
-			"Open %s failed %d (%s)\n",
+		zonefs_set_error(dev, errno,
+			"Open %s failed %d (%s)",
 			dev->path,
 			errno, strerror(errno));
 		return -1;
 	}
 
-	if (check_overwrite && !(dev->flags & ZONEFS_OVERWRITE)) {
-		/* Check for existing valid content */
-		ret = zonefs_check_overwrite(dev);
-		if (ret <= 0)
-			goto err;
-	}
-
 	/* We need direct writes */
 	ret = fcntl(dev->fd, F_SETFL, O_DIRECT);
 	if (ret) {
-		fprintf(stderr,
-			"Set O_DIRECT failed %d (%s)\n",
+		zonefs_set_error(dev, errno,
+			"Set O_DIRECT failed %d (%s)",
 			errno, strerror(errno));
-		goto err;
+		zonefs_close_dev(dev);
+		return -1;
 	}
 
+	return 0;
+}
+
+/*
+ * Open a device. The check for existing content on the device is executed
+ * concurrently with the device zone report.
+ */
+int zonefs_open_dev(struct zonefs_dev *dev, bool check_overwrite)
+{
+	struct zonefs_probe probe = { .dev = dev, .ret = 1 };
+	int ret;
+
+	zonefs_clear_error(dev);
+
+	if (zonefs_do_open_dev(dev))
+		return -1;
+
+	if (check_overwrite && !(dev->flags & ZONEFS_OVERWRITE))
+		zonefs_start_probe(&probe);
+
 	/* Get device capacity and zone configuration */
-	if (zonefs_get_dev_info(dev) < 0)
-		goto err;
+	ret = zonefs_get_dev_info(dev);
+	if (!ret)
+		ret = zonefs_report_dev_zones(dev, NULL);
 
-	return 0;
+	if (zonefs_wait_probe(&probe) <= 0 || ret < 0) {
+		zonefs_close_dev(dev);
+		return -1;
+	}
 
-err:
-	zonefs_close_dev(dev);
-	return -1;
+	return 0;
 }
 
 /*
@@ -569,38 +1112,52 @@ void zonefs_close_dev(struct zonefs_dev *dev)
 		dev->fd = -1;
 	}
 
-	free(dev->zones);
-	dev->zones = NULL;
+	free(dev->zones.wp_ofst);
+	free(dev->zones.type);
+	free(dev->zones.cond);
+	memset(&dev->zones, 0, sizeof(dev->zones));
 }
 
+static pthread_mutex_t zonefs_blkid_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
 /*
  * Write a metadata block.
  */
 int zonefs_sync_dev(struct zonefs_dev *dev)
 {
+	unsigned long long start = zonefs_usec();
 	blkid_cache cache;
 	int ret;
 
+	zonefs_clear_error(dev);
+
 	ret = fsync(dev->fd);
 	if (ret < 0) {
-		fprintf(stderr,
-			"%s: fsync failed %d (%s)\n",
+		zonefs_set_error(dev, errno,
+			"%s: fsync failed %d (%s)",
 			dev->name,
 			errno, strerror(errno));
+		zonefs_phase_done(dev, ZONEFS_PHASE_SYNC, start);
 		return -1;
 	}
 
 	/*
 	 * Make sure udev notices the uuid and label changes so that blkid
-	 * cache and by-uuid/by-label device links all get updated.
+	 * cache and by-uuid/by-label device links all get updated. The blkid
+	 * cache is shared, so serialize its update when several devices are
+	 * synced concurrently.
 	 */
+	pthread_mutex_lock(&zonefs_blkid_cache_lock);
 	ret = blkid_get_cache(&cache, NULL);
 	if (ret >= 0) {
 		blkid_get_dev(cache, dev->path, BLKID_DEV_NORMAL);
 		blkid_put_cache(cache);
 	}
+	pthread_mutex_unlock(&zonefs_blkid_cache_lock);
 	blkid_send_uevent(dev->path, "change");
 
+	zonefs_phase_done(dev, ZONEFS_PHASE_SYNC, start);
+
 	return 0;
 }
 
@@ -609,29 +1166,35 @@ int zonefs_sync_dev(struct zonefs_dev *dev)
  */
 #ifdef BLKFINISHZONE
 
-int zonefs_finish_zone(struct zonefs_dev *dev, struct blk_zone *zone)
+int zonefs_finish_zone(struct zonefs_dev *dev, unsigned int zno)
 {
 	struct blk_zone_range range;
 
-	if (zone->type == BLK_ZONE_TYPE_CONVENTIONAL)
+	zonefs_clear_error(dev);
+
+	if (zonefs_zone_is_conv(dev, zno))
 		return 0;
 
 	/* Sequential zone: transition it to full state */
-	range.sector = zone->start;
-	range.nr_sectors = zone->len;
+	range.sector = zonefs_zone_start(dev, zno);
+	range.nr_sectors = zonefs_zone_len(dev, zno);
+	zonefs_count_ioctl(dev, nr_finish_ioctls);
 	if (ioctl(dev->fd, BLKFINISHZONE, &range) < 0) {
-		fprintf(stderr,
-			"%s: Finish zone %u failed %d (%s)\n",
-			dev->name, zonefs_zone_id(dev, zone),
+		zonefs_set_error(dev, errno,
+			"%s: Finish zone %u failed %d (%s)",
+			dev->name, zno,
 			errno, strerror(errno));
 		return -1;
 	}
 
+	zonefs_zone_set_wp(dev, zno, range.sector + range.nr_sectors);
+	zonefs_zone_set_cond(dev, zno, BLK_ZONE_COND_FULL);
+
 	return 0;
 }
 #else
 
-int zonefs_finish_zone(struct zonefs_dev *dev, struct blk_zone *zone)
+int zonefs_finish_zone(struct zonefs_dev *dev, unsigned int zno)
 {
 	return 0;
 }
@@ -639,61 +1202,1040 @@ int zonefs_finish_zone(struct zonefs_dev *dev, struct blk_zone *zone)
 #endif /* BLKFINISHZONE */
 
 /*
- * Reset a zone.
+ * Range of contiguous sequential zones to reset.
+ */
+struct zonefs_reset_range {
+	unsigned int		zno;
+	unsigned int		nr_zones;
+};
+
+/*
+ * Zone reset plan.
  */
-static int zonefs_reset_zone(struct zonefs_dev *dev, struct blk_zone *zone)
+struct zonefs_reset_plan {
+	struct zonefs_reset_range *ranges;
+	unsigned int		nr_ranges;
+	unsigned int		nr_zones;
+};
+
+/*
+ * Reset a range of contiguous sequential zones.
+ */
+static int zonefs_reset_range(struct zonefs_dev *dev,
+			      struct zonefs_reset_range *r)
 {
+	unsigned int last = r->zno + r->nr_zones - 1;
 	struct blk_zone_range range;
+	unsigned int i;
 
-	if (zone->type == BLK_ZONE_TYPE_CONVENTIONAL)
-		return 0;
-
-	/* Sequential zone: reset */
-	range.sector = zone->start;
-	range.nr_sectors = zone->len;
+	range.sector = zonefs_zone_start(dev, r->zno);
+	range.nr_sectors = zonefs_zone_start(dev, last) +
+		zonefs_zone_len(dev, last) - range.sector;
+	zonefs_count_ioctl(dev, nr_reset_ioctls);
 	if (ioctl(dev->fd, BLKRESETZONE, &range) < 0) {
-		fprintf(stderr,
-			"%s: Reset zone %u failed %d (%s)\n",
-			dev->name, zonefs_zone_id(dev, zone),
-			errno, strerror(errno));
+		if (r->nr_zones == 1)
+			zonefs_set_error(dev, errno,
+				"%s: Reset zone %u failed %d (%s)",
+				dev->name, r->zno,
+				errno, strerror(errno));
+		else
+			zonefs_set_error(dev, errno,
+				"%s: Reset zones %u-%u failed %d (%s)",
+				dev->name, r->zno, r->zno + r->nr_zones - 1,
+				errno, strerror(errno));
 		return -1;
 	}
 
-	zone->wp = zone->start;
+	for (i = r->zno; i <= last; i++) {
+		dev->zones.wp_ofst[i] = 0;
+		zonefs_zone_set_cond(dev, i, BLK_ZONE_COND_EMPTY);
+	}
 
 	return 0;
 }
 
 /*
- * Reset all zones of a device.
+ * Test if a zone needs to be reset. In incremental mode, only sequential
+ * zones that are not empty and can be written are reset.
  */
-int zonefs_reset_zones(struct zonefs_dev *dev)
+static bool zonefs_zone_need_reset(struct zonefs_dev *dev, unsigned int zno)
 {
-	struct blk_zone_range range;
-	unsigned int i;
-	int ret;
+	if (zonefs_zone_is_conv(dev, zno))
+		return false;
 
-	/*
-	 * Try to reset all zones. This does not work on all devices so if
-	 * this fails, fall back to resetting zones one at a time.
+	if (!(dev->flags & ZONEFS_INCREMENTAL))
+		return true;
+
+	switch (zonefs_zone_cond(dev, zno)) {
+	case BLK_ZONE_COND_EMPTY:
+	case BLK_ZONE_COND_READONLY:
+	case BLK_ZONE_COND_OFFLINE:
+		return false;
+	default:
+		return true;
+	}
+}
+
+/*
+ * Build the list of zone ranges to reset. Without incremental mode, zones
+ * are reset one at a time. In incremental mode, contiguous zones needing
+ * a reset are merged into a single range, limiting the range size so that
+ * all reset threads get some work.
+ */
+static int zonefs_get_reset_plan(struct zonefs_dev *dev,
+				 struct zonefs_reset_plan *plan,
+				 unsigned int nr_workers)
+{
+	struct zonefs_reset_range *r = NULL;
+	unsigned int i, max_run = 1;
+
+	memset(plan, 0, sizeof(*plan));
+
+	for (i = 0; i < dev->nr_zones; i++) {
+		if (zonefs_zone_need_reset(dev, i))
+			plan->nr_zones++;
+	}
+
+	if (!plan->nr_zones)
+		return 0;
+
+	plan->ranges = calloc(plan->nr_zones,
+			      sizeof(struct zonefs_reset_range));
+	if (!plan->ranges) {
+		zonefs_set_error(dev, ENOMEM, "Not enough memory");
+		return -1;
+	}
+
+	if (dev->flags & ZONEFS_INCREMENTAL)
+		max_run = (plan->nr_zones + nr_workers - 1) / nr_workers;
+
+	for (i = 0; i < dev->nr_zones; i++) {
+		if (!zonefs_zone_need_reset(dev, i)) {
+			r = NULL;
+			continue;
+		}
+
+		if (r && r->nr_zones < max_run) {
+			r->nr_zones++;
+			continue;
+		}
+
+		r = &plan->ranges[plan->nr_ranges];
+		r->zno = i;
+		r->nr_zones = 1;
+		plan->nr_ranges++;
+	}
+
+	return 0;
+}
+
+/*
+ * Print a zone reset plan.
+ */
+static void zonefs_print_reset_plan(struct zonefs_dev *dev,
+				    struct zonefs_reset_plan *plan)
+{
+	struct zonefs_reset_range *r;
+	unsigned int i, last;
+	__u64 start;
+
+	fprintf(dev->out, "  Reset plan: %u zone%s in %u range%s\n",
+		plan->nr_zones, plan->nr_zones > 1 ? "s" : "",
+		plan->nr_ranges, plan->nr_ranges > 1 ? "s" : "");
+
+	for (i = 0; i < plan->nr_ranges; i++) {
+		r = &plan->ranges[i];
+		last = r->zno + r->nr_zones - 1;
+		start = zonefs_zone_start(dev, r->zno);
+		if (r->nr_zones == 1)
+			fprintf(dev->out,
+				"    Zone %05u: sector %llu, %llu sectors\n",
+				r->zno, start, zonefs_zone_len(dev, r->zno));
+		else
+			fprintf(dev->out,
+				"    Zones %05u-%05u: sector %llu, %llu sectors\n",
+				r->zno, last, start,
+				zonefs_zone_start(dev, last) +
+				zonefs_zone_len(dev, last) - start);
+	}
+}
+
+/*
+ * Parallel zone reset context.
+ */
+struct zonefs_reset_ctx {
+	struct zonefs_dev	*dev;
+	struct zonefs_reset_plan *plan;
+
+	/* Next range to reset and number of zones reset */
+	unsigned int		next_range;
+	unsigned int		nr_done;
+	int			error;
+
+	/* Running workers tracking */
+	pthread_mutex_t		lock;
+	pthread_cond_t		cond;
+	unsigned int		nr_running;
+};
+
+/*
+ * Zone reset worker: grab zone ranges one at a time until all ranges are
+ * processed or an error happens.
+ */
+static void *zonefs_reset_worker(void *arg)
+{
+	struct zonefs_reset_ctx *ctx = arg;
+	struct zonefs_reset_plan *plan = ctx->plan;
+	struct zonefs_reset_range *r;
+	unsigned int i;
+
+	while (!__atomic_load_n(&ctx->error, __ATOMIC_RELAXED)) {
+		i = __atomic_fetch_add(&ctx->next_range, 1, __ATOMIC_RELAXED);
+		if (i >= plan->nr_ranges)
+			break;
+
+		r = &plan->ranges[i];
+		if (zonefs_reset_range(ctx->dev, r)) {
+			__atomic_store_n(&ctx->error, 1, __ATOMIC_RELAXED);
+			break;
+		}
+
+		__atomic_fetch_add(&ctx->nr_done, r->nr_zones,
+				   __ATOMIC_RELAXED);
+	}
+
+	pthread_mutex_lock(&ctx->lock);
+	ctx->nr_running--;
+	pthread_cond_signal(&ctx->cond);
+	pthread_mutex_unlock(&ctx->lock);
+
+	return NULL;
+}
+
+/*
+ * Print zone reset progress.
+ */
+static void zonefs_reset_progress(struct zonefs_reset_ctx *ctx)
+{
+	unsigned int nr_zones = ctx->plan->nr_zones;
+	unsigned int nr_done;
+
+	if (!(ctx->dev->flags & ZONEFS_PROGRESS))
+		return;
+
+	nr_done = __atomic_load_n(&ctx->nr_done, __ATOMIC_RELAXED);
+	fprintf(ctx->dev->out, "\r  %u / %u zones reset (%u %%)",
+		nr_done, nr_zones,
+		(unsigned int)(nr_done * 100ULL / nr_zones));
+	fflush(ctx->dev->out);
+}
+
+/*
+ * Reset zone ranges using multiple threads.
+ */
+static int zonefs_reset_zones_parallel(struct zonefs_dev *dev,
+				       struct zonefs_reset_plan *plan,
+				       unsigned int nr_workers)
+{
+	struct zonefs_reset_ctx ctx;
+	pthread_t threads[ZONEFS_MAX_WORKERS];
+	unsigned int i, nr_threads = 0;
+	struct timespec ts;
+	int ret;
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.dev = dev;
+	ctx.plan = plan;
+	pthread_mutex_init(&ctx.lock, NULL);
+	pthread_cond_init(&ctx.cond, NULL);
+
+	for (i = 0; i < nr_workers; i++) {
+		pthread_mutex_lock(&ctx.lock);
+		ctx.nr_running++;
+		pthread_mutex_unlock(&ctx.lock);
+
+		ret = pthread_create(&threads[i], NULL,
+				     zonefs_reset_worker, &ctx);
+		if (ret) {
+			zonefs_set_error(dev, ret,
+				"%s: Create reset thread failed %d (%s)",
+				dev->name, ret, strerror(ret));
+			pthread_mutex_lock(&ctx.lock);
+			ctx.nr_running--;
+			pthread_mutex_unlock(&ctx.lock);
+			if (!nr_threads) {
+				ctx.error = 1;
+				goto out;
+			}
+			break;
+		}
+		nr_threads++;
+	}
+
+	/* Wait for the workers, reporting progress every half second */
+	pthread_mutex_lock(&ctx.lock);
+	while (ctx.nr_running) {
+		clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_nsec += 500000000;
+		if (ts.tv_nsec >= 1000000000) {
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000000000;
+		}
+		pthread_cond_timedwait(&ctx.cond, &ctx.lock, &ts);
+		zonefs_reset_progress(&ctx);
+	}
+	pthread_mutex_unlock(&ctx.lock);
+
+	for (i = 0; i < nr_threads; i++)
+		pthread_join(threads[i], NULL);
+
+	if (dev->flags & ZONEFS_PROGRESS)
+		fprintf(dev->out, "\n");
+
+out:
+	pthread_cond_destroy(&ctx.cond);
+	pthread_mutex_destroy(&ctx.lock);
+
+	return ctx.error ? -1 : 0;
+}
+
+static int __zonefs_reset_zones(struct zonefs_dev *dev)
+{
+	struct zonefs_reset_plan plan;
+	struct blk_zone_range range;
+	unsigned int i, nr_workers;
+	int ret;
+
+	/*
+	 * Try to reset all zones. This does not work on all devices so if
+	 * this fails, fall back to resetting zones one at a time.
 	 */
-	if (zonefs_dev_has_reset_all(dev)) {
+	if (!(dev->flags & ZONEFS_INCREMENTAL) &&
+	    zonefs_dev_has_reset_all(dev)) {
+		if (dev->flags & ZONEFS_DRY_RUN) {
+			fprintf(dev->out, "  Reset plan: all zones\n");
+			return 0;
+		}
+
 		range.sector = 0;
 		range.nr_sectors = dev->capacity;
+		zonefs_count_ioctl(dev, nr_reset_ioctls);
 		ret = ioctl(dev->fd, BLKRESETZONE, &range);
 		if (!ret) {
-			for (i = 0; i < dev->nr_zones; i++)
-				dev->zones[i].wp = dev->zones[i].start;
+			for (i = 0; i < dev->nr_zones; i++) {
+				if (zonefs_zone_is_conv(dev, i))
+					continue;
+				dev->zones.wp_ofst[i] = 0;
+				zonefs_zone_set_cond(dev, i,
+						     BLK_ZONE_COND_EMPTY);
+			}
 			return 0;
 		}
 	}
 
-	/* Fallback to zone reset zones one at a time */
-	for (i = 0; i < dev->nr_zones; i++) {
-		ret = zonefs_reset_zone(dev, &dev->zones[i]);
+	/* Fallback to resetting zone ranges */
+	nr_workers = zonefs_nr_workers(dev, dev->nr_seq_zones);
+	if (zonefs_get_reset_plan(dev, &plan, nr_workers) < 0)
+		return -1;
+
+	if (dev->flags & (ZONEFS_VERBOSE | ZONEFS_DRY_RUN))
+		zonefs_print_reset_plan(dev, &plan);
+
+	if (!plan.nr_ranges || (dev->flags & ZONEFS_DRY_RUN)) {
+		ret = 0;
+		goto out;
+	}
+
+	if (nr_workers > plan.nr_ranges)
+		nr_workers = plan.nr_ranges;
+	if (nr_workers > 1) {
+		ret = zonefs_reset_zones_parallel(dev, &plan, nr_workers);
+		goto out;
+	}
+
+	for (i = 0; i < plan.nr_ranges; i++) {
+		ret = zonefs_reset_range(dev, &plan.ranges[i]);
 		if (ret)
-			return ret;
+			break;
+	}
+
+out:
+	free(plan.ranges);
+
+	return ret;
+}
+
+/*
+ * Reset the zones of a device. Without incremental mode, all sequential
+ * zones are reset. In dry-run mode, only print the zones that would be
+ * reset.
+ */
+int zonefs_reset_zones(struct zonefs_dev *dev)
+{
+	unsigned long long start = zonefs_usec();
+	int ret;
+
+	zonefs_clear_error(dev);
+
+	ret = __zonefs_reset_zones(dev);
+	zonefs_phase_done(dev, ZONEFS_PHASE_ZONE_RESET, start);
+
+	return ret;
+}
+
+/*
+ * Reset the zones needing a reset in a batch of reported zones. Without
+ * incremental mode, zones are reset one at a time. In incremental mode,
+ * contiguous zones needing a reset are merged into a single range.
+ */
+static int zonefs_pipe_reset_batch(struct zonefs_pipe *pipe,
+				   struct zonefs_pipe_batch *b)
+{
+	struct zonefs_dev *dev = pipe->dev;
+	unsigned int end = b->zno + b->nr_zones;
+	struct zonefs_reset_range r;
+	unsigned int i;
+
+	for (i = b->zno; i < end; i++) {
+		if (!zonefs_zone_need_reset(dev, i))
+			continue;
+
+		r.zno = i;
+		r.nr_zones = 1;
+		if (dev->flags & ZONEFS_INCREMENTAL) {
+			while (i + 1 < end &&
+			       zonefs_zone_need_reset(dev, i + 1)) {
+				r.nr_zones++;
+				i++;
+			}
+		}
+
+		if (zonefs_reset_range(dev, &r))
+			return -1;
+
+		__atomic_fetch_add(&pipe->nr_done, r.nr_zones,
+				   __ATOMIC_RELAXED);
+	}
+
+	return 0;
+}
+
+/*
+ * Pipeline zone reset worker: wait for the existing content probe to allow
+ * overwriting the device and for the zone report to show that the device
+ * is usable, then reset batches of reported zones until the zone report
+ * completes or an error happens. If the device is not usable, the zone
+ * report completion aborts the pipeline.
+ */
+static void *zonefs_pipe_reset_worker(void *arg)
+{
+	struct zonefs_pipe *pipe = arg;
+	struct zonefs_pipe_batch *b;
+
+	for (;;) {
+		pthread_mutex_lock(&pipe->lock);
+		while (!pipe->error &&
+		       (!pipe->probe_done ||
+			(pipe->nr_usable < 2 && !pipe->report_done) ||
+			(!pipe->head && !pipe->report_done)))
+			pthread_cond_wait(&pipe->cond, &pipe->lock);
+		b = NULL;
+		if (!pipe->error && pipe->head) {
+			b = pipe->head;
+			pipe->head = b->next;
+			if (!pipe->head)
+				pipe->tail = NULL;
+		}
+		pthread_mutex_unlock(&pipe->lock);
+
+		if (!b)
+			break;
+
+		if (zonefs_pipe_reset_batch(pipe, b)) {
+			free(b);
+			zonefs_pipe_abort(pipe);
+			break;
+		}
+		free(b);
+	}
+
+	pthread_mutex_lock(&pipe->lock);
+	pipe->nr_running--;
+	pthread_cond_broadcast(&pipe->cond);
+	pthread_mutex_unlock(&pipe->lock);
+
+	return NULL;
+}
+
+/*
+ * Sum of the times of the pipelined phases.
+ */
+static unsigned long long zonefs_pipe_phases_usec(struct zonefs_dev *dev)
+{
+	return dev->stats.phase_usec[ZONEFS_PHASE_PROBE] +
+		dev->stats.phase_usec[ZONEFS_PHASE_DEV_INFO] +
+		dev->stats.phase_usec[ZONEFS_PHASE_ZONE_REPORT] +
+		dev->stats.phase_usec[ZONEFS_PHASE_ZONE_RESET];
+}
+
+/*
+ * Zones are reset as they are reported, so that a zone report error on the
+ * last zones of the device leaves the first zones reset. Reduce this risk
+ * by checking that the zone size and number of zones of the device match
+ * its capacity before resetting any zone.
+ */
+static int zonefs_pipe_check_geometry(struct zonefs_dev *dev)
+{
+	unsigned long long nr_zones;
+	__u32 val;
+
+	nr_zones = (dev->capacity + dev->zone_nr_sectors - 1) /
+		dev->zone_nr_sectors;
+	if (!nr_zones) {
+		zonefs_set_error(dev, EINVAL, "%s: No zones", dev->name);
+		return -1;
+	}
+
+	zonefs_count_ioctl(dev, nr_other_ioctls);
+	if (ioctl(dev->fd, BLKGETZONESZ, &val) < 0) {
+		zonefs_set_error(dev, errno,
+			"%s: Get zone size failed %d (%s)",
+			dev->name, errno, strerror(errno));
+		return -1;
+	}
+	if (val != dev->zone_nr_sectors) {
+		zonefs_set_error(dev, EINVAL,
+			"%s: Invalid zone size (expected %zu, got %u)",
+			dev->name, dev->zone_nr_sectors, val);
+		return -1;
+	}
+
+	zonefs_count_ioctl(dev, nr_other_ioctls);
+	if (ioctl(dev->fd, BLKGETNRZONES, &val) < 0) {
+		zonefs_set_error(dev, errno,
+			"%s: Get number of zones failed %d (%s)",
+			dev->name, errno, strerror(errno));
+		return -1;
+	}
+	if (val != nr_zones) {
+		zonefs_set_error(dev, EINVAL,
+			"%s: Invalid number of zones (expected %llu, got %u)",
+			dev->name, nr_zones, val);
+		return -1;
 	}
 
 	return 0;
 }
+
+/*
+ * Run the format pipeline: overlap the existing content probe, the zone
+ * report and the zone reset. The time counted in more than one of these
+ * phases is accounted as overlap time.
+ */
+static int zonefs_pipe_run(struct zonefs_dev *dev, bool check_overwrite)
+{
+	struct zonefs_probe probe = { .dev = dev, .ret = 1 };
+	pthread_t threads[ZONEFS_MAX_WORKERS];
+	unsigned int i, nr_workers, nr_threads = 0;
+	unsigned long long start, pipe_start, phases_usec, wall_usec;
+	struct zonefs_pipe pipe;
+	struct zonefs_pipe_batch *b;
+	struct timespec ts;
+	int ret;
+
+	pipe_start = zonefs_usec();
+	phases_usec = zonefs_pipe_phases_usec(dev);
+
+	if (zonefs_get_dev_info(dev) < 0 ||
+	    zonefs_pipe_check_geometry(dev) < 0)
+		return -1;
+
+	memset(&pipe, 0, sizeof(pipe));
+	pipe.dev = dev;
+	pthread_mutex_init(&pipe.lock, NULL);
+	pthread_cond_init(&pipe.cond, NULL);
+
+	if (check_overwrite && !(dev->flags & ZONEFS_OVERWRITE)) {
+		probe.pipe = &pipe;
+		zonefs_start_probe(&probe);
+	} else {
+		pipe.probe_done = true;
+	}
+
+	/* Start the zone reset workers */
+	start = zonefs_usec();
+	nr_workers = zonefs_nr_workers(dev,
+		(dev->capacity + dev->zone_nr_sectors - 1) /
+		dev->zone_nr_sectors);
+	for (i = 0; i < nr_workers; i++) {
+		pthread_mutex_lock(&pipe.lock);
+		pipe.nr_running++;
+		pthread_mutex_unlock(&pipe.lock);
+
+		ret = pthread_create(&threads[i], NULL,
+				     zonefs_pipe_reset_worker, &pipe);
+		if (ret) {
+			zonefs_set_error(dev, ret,
+				"%s: Create reset thread failed %d (%s)",
+				dev->name, ret, strerror(ret));
+			pthread_mutex_lock(&pipe.lock);
+			pipe.nr_running--;
+			pthread_mutex_unlock(&pipe.lock);
+			if (!nr_threads)
+				zonefs_pipe_abort(&pipe);
+			break;
+		}
+		nr_threads++;
+	}
+
+	/* Report zones, feeding the zone reset workers */
+	ret = zonefs_report_dev_zones(dev, &pipe);
+	pthread_mutex_lock(&pipe.lock);
+	pipe.report_done = true;
+	if (!ret && !zonefs_dev_usable(dev)) {
+		zonefs_set_error(dev, ENOSPC, "%s: No useable zones",
+				 dev->name);
+		ret = -1;
+	}
+	if (ret)
+		pipe.error = 1;
+	pthread_cond_broadcast(&pipe.cond);
+	pthread_mutex_unlock(&pipe.lock);
+
+	/* Wait for the workers, reporting progress every half second */
+	pthread_mutex_lock(&pipe.lock);
+	while (pipe.nr_running) {
+		clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_nsec += 500000000;
+		if (ts.tv_nsec >= 1000000000) {
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000000000;
+		}
+		pthread_cond_timedwait(&pipe.cond, &pipe.lock, &ts);
+		if (dev->flags & ZONEFS_PROGRESS) {
+			fprintf(dev->out, "\r  %u zones reset",
+				__atomic_load_n(&pipe.nr_done,
+						__ATOMIC_RELAXED));
+			fflush(dev->out);
+		}
+	}
+	pthread_mutex_unlock(&pipe.lock);
+
+	for (i = 0; i < nr_threads; i++)
+		pthread_join(threads[i], NULL);
+	zonefs_phase_done(dev, ZONEFS_PHASE_ZONE_RESET, start);
+
+	if (dev->flags & ZONEFS_PROGRESS)
+		fprintf(dev->out, "\n");
+
+	if (zonefs_wait_probe(&probe) <= 0)
+		pipe.error = 1;
+
+	wall_usec = zonefs_usec() - pipe_start;
+	phases_usec = zonefs_pipe_phases_usec(dev) - phases_usec;
+	if (phases_usec > wall_usec)
+		dev->stats.overlap_usec += phases_usec - wall_usec;
+
+	/* Free unprocessed batches left over on error */
+	while (pipe.head) {
+		b = pipe.head;
+		pipe.head = b->next;
+		free(b);
+	}
+
+	pthread_cond_destroy(&pipe.cond);
+	pthread_mutex_destroy(&pipe.lock);
+
+	return pipe.error ? -1 : 0;
+}
+
+/*
+ * Test if zonefs_open_reset_dev() pipelines the existing content probe, the
+ * zone report and the zone reset of a device. This is not the case if all
+ * zones can be reset at once or if the zones and reset plan must be printed
+ * (verbose and dry-run modes).
+ */
+bool zonefs_dev_pipelined(struct zonefs_dev *dev)
+{
+	dev->name = basename(dev->path);
+
+	if (dev->flags & (ZONEFS_VERBOSE | ZONEFS_DRY_RUN))
+		return false;
+
+	return (dev->flags & ZONEFS_INCREMENTAL) ||
+		!zonefs_dev_has_reset_all(dev);
+}
+
+/*
+ * Open a device and reset its zones, pipelining the existing content probe,
+ * the zone report and the zone reset if possible. The zones are not reset
+ * if the device contains valid data and overwriting is not allowed, or if
+ * the device has no usable zone.
+ */
+int zonefs_open_reset_dev(struct zonefs_dev *dev, bool check_overwrite)
+{
+	int ret;
+
+	zonefs_clear_error(dev);
+
+	if (!zonefs_dev_pipelined(dev)) {
+		if (zonefs_open_dev(dev, check_overwrite) < 0)
+			return -1;
+		if (zonefs_dev_usable(dev)) {
+			ret = zonefs_reset_zones(dev);
+		} else {
+			zonefs_set_error(dev, ENOSPC, "%s: No useable zones",
+					 dev->name);
+			ret = -1;
+		}
+	} else {
+		if (zonefs_do_open_dev(dev) < 0)
+			return -1;
+		ret = zonefs_pipe_run(dev, check_overwrite);
+	}
+
+	if (ret) {
+		zonefs_close_dev(dev);
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Conventional zones are wiped in chunks of at most ZONEFS_WIPE_CHUNK_SECTORS
+ * sectors. With a bandwidth limit, chunks are reduced to about a tenth of a
+ * second worth of data so that the limit is applied smoothly.
+ */
+#define ZONEFS_WIPE_CHUNK_SECTORS	(256ULL * 1024 * 2)	/* 256 MiB */
+#define ZONEFS_WIPE_MIN_CHUNK_SECTORS	(1024ULL * 2)		/* 1 MiB */
+
+/*
+ * Chunk of contiguous conventional zone sectors to wipe.
+ */
+struct zonefs_wipe_chunk {
+	__u64			sector;
+	__u64			nr_sectors;
+};
+
+/*
+ * Parallel conventional zones wipe context.
+ */
+struct zonefs_wipe_ctx {
+	struct zonefs_dev	*dev;
+	struct zonefs_wipe_chunk *chunks;
+	unsigned int		nr_chunks;
+	__u64			nr_sectors;
+
+	/* Next chunk to wipe and number of sectors wiped */
+	unsigned int		next_chunk;
+	__u64			nr_done;
+	int			error;
+
+	/* Bandwidth limit: time at which the next chunk can be issued */
+	unsigned long long	next_usec;
+
+	/* Running workers tracking */
+	pthread_mutex_t		lock;
+	pthread_cond_t		cond;
+	unsigned int		nr_running;
+};
+
+/*
+ * Test if a zone is a conventional zone that can be wiped.
+ */
+static bool zonefs_zone_need_wipe(struct zonefs_dev *dev, unsigned int zno)
+{
+	if (!zonefs_zone_is_conv(dev, zno))
+		return false;
+
+	switch (zonefs_zone_cond(dev, zno)) {
+	case BLK_ZONE_COND_READONLY:
+	case BLK_ZONE_COND_OFFLINE:
+		return false;
+	default:
+		return true;
+	}
+}
+
+/*
+ * Split the ranges of contiguous conventional zones into chunks. If
+ * ctx->chunks is NULL, only count the chunks and the sectors to wipe.
+ */
+static unsigned int zonefs_split_wipe_chunks(struct zonefs_wipe_ctx *ctx,
+					     __u64 chunk_sectors)
+{
+	struct zonefs_dev *dev = ctx->dev;
+	struct zonefs_wipe_chunk *c;
+	unsigned int i, j, nr_chunks = 0;
+	__u64 sector, end, n;
+
+	for (i = 0; i < dev->nr_zones; i = j + 1) {
+		j = i;
+		if (!zonefs_zone_need_wipe(dev, i))
+			continue;
+		while (j + 1 < dev->nr_zones &&
+		       zonefs_zone_need_wipe(dev, j + 1))
+			j++;
+
+		sector = zonefs_zone_start(dev, i);
+		end = zonefs_zone_start(dev, j) + zonefs_zone_len(dev, j);
+		if (!ctx->chunks)
+			ctx->nr_sectors += end - sector;
+		for (; sector < end; sector += n) {
+			n = end - sector;
+			if (n > chunk_sectors)
+				n = chunk_sectors;
+			if (ctx->chunks) {
+				c = &ctx->chunks[nr_chunks];
+				c->sector = sector;
+				c->nr_sectors = n;
+			}
+			nr_chunks++;
+		}
+	}
+
+	return nr_chunks;
+}
+
+/*
+ * Get the list of chunks to wipe.
+ */
+static int zonefs_get_wipe_chunks(struct zonefs_wipe_ctx *ctx,
+				  __u64 chunk_sectors)
+{
+	unsigned int nr_chunks;
+
+	nr_chunks = zonefs_split_wipe_chunks(ctx, chunk_sectors);
+	if (!nr_chunks)
+		return 0;
+
+	ctx->chunks = calloc(nr_chunks, sizeof(struct zonefs_wipe_chunk));
+	if (!ctx->chunks) {
+		zonefs_set_error(ctx->dev, ENOMEM, "Not enough memory");
+		return -1;
+	}
+	ctx->nr_chunks = zonefs_split_wipe_chunks(ctx, chunk_sectors);
+
+	return 0;
+}
+
+/*
+ * With a bandwidth limit, wait until a chunk can be issued.
+ */
+static void zonefs_wipe_throttle(struct zonefs_wipe_ctx *ctx,
+				 struct zonefs_wipe_chunk *c)
+{
+	unsigned long long now, issue_usec;
+
+	if (!ctx->dev->wipe_bw)
+		return;
+
+	pthread_mutex_lock(&ctx->lock);
+	now = zonefs_usec();
+	issue_usec = ctx->next_usec;
+	if (issue_usec < now)
+		issue_usec = now;
+	ctx->next_usec = issue_usec +
+		(c->nr_sectors << 9) * 1000000ULL / ctx->dev->wipe_bw;
+	pthread_mutex_unlock(&ctx->lock);
+
+	if (issue_usec > now)
+		usleep(issue_usec - now);
+}
+
+/*
+ * Zero out or discard a chunk of conventional zone sectors.
+ */
+static int zonefs_wipe_chunk(struct zonefs_wipe_ctx *ctx,
+			     struct zonefs_wipe_chunk *c)
+{
+	struct zonefs_dev *dev = ctx->dev;
+	unsigned long long range[2];
+	unsigned long req;
+	const char *op;
+
+	if (dev->wipe == ZONEFS_WIPE_DISCARD) {
+		req = BLKDISCARD;
+		op = "Discard";
+	} else {
+		req = BLKZEROOUT;
+		op = "Zero out";
+	}
+
+	zonefs_wipe_throttle(ctx, c);
+
+	range[0] = c->sector << 9;
+	range[1] = c->nr_sectors << 9;
+	zonefs_count_ioctl(dev, nr_wipe_ioctls);
+	if (ioctl(dev->fd, req, range) < 0) {
+		zonefs_set_error(dev, errno,
+			"%s: %s sectors %llu-%llu failed %d (%s)",
+			dev->name, op, c->sector, c->sector + c->nr_sectors - 1,
+			errno, strerror(errno));
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Conventional zones wipe worker: grab chunks one at a time until all
+ * chunks are processed or an error happens.
+ */
+static void *zonefs_wipe_worker(void *arg)
+{
+	struct zonefs_wipe_ctx *ctx = arg;
+	struct zonefs_wipe_chunk *c;
+	unsigned int i;
+
+	while (!__atomic_load_n(&ctx->error, __ATOMIC_RELAXED)) {
+		i = __atomic_fetch_add(&ctx->next_chunk, 1, __ATOMIC_RELAXED);
+		if (i >= ctx->nr_chunks)
+			break;
+
+		c = &ctx->chunks[i];
+		if (zonefs_wipe_chunk(ctx, c)) {
+			__atomic_store_n(&ctx->error, 1, __ATOMIC_RELAXED);
+			break;
+		}
+
+		__atomic_fetch_add(&ctx->nr_done, c->nr_sectors,
+				   __ATOMIC_RELAXED);
+	}
+
+	pthread_mutex_lock(&ctx->lock);
+	ctx->nr_running--;
+	pthread_cond_signal(&ctx->cond);
+	pthread_mutex_unlock(&ctx->lock);
+
+	return NULL;
+}
+
+/*
+ * Print conventional zones wipe progress.
+ */
+static void zonefs_wipe_progress(struct zonefs_wipe_ctx *ctx)
+{
+	__u64 nr_done;
+
+	if (!(ctx->dev->flags & ZONEFS_PROGRESS))
+		return;
+
+	nr_done = __atomic_load_n(&ctx->nr_done, __ATOMIC_RELAXED);
+	fprintf(ctx->dev->out, "\r  %llu / %llu MiB wiped (%u %%)",
+		nr_done >> 11, ctx->nr_sectors >> 11,
+		(unsigned int)(nr_done * 100ULL / ctx->nr_sectors));
+	fflush(ctx->dev->out);
+}
+
+static int __zonefs_wipe_cnv_zones(struct zonefs_dev *dev)
+{
+	pthread_t threads[ZONEFS_MAX_WORKERS];
+	unsigned int i, nr_workers, nr_threads = 0;
+	__u64 chunk_sectors = ZONEFS_WIPE_CHUNK_SECTORS;
+	struct zonefs_wipe_ctx ctx;
+	struct timespec ts;
+	int ret;
+
+	if (dev->wipe_bw) {
+		chunk_sectors = (dev->wipe_bw / 10) >> 9;
+		chunk_sectors &= ~(ZONEFS_WIPE_MIN_CHUNK_SECTORS - 1);
+		if (chunk_sectors < ZONEFS_WIPE_MIN_CHUNK_SECTORS)
+			chunk_sectors = ZONEFS_WIPE_MIN_CHUNK_SECTORS;
+		else if (chunk_sectors > ZONEFS_WIPE_CHUNK_SECTORS)
+			chunk_sectors = ZONEFS_WIPE_CHUNK_SECTORS;
+	}
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.dev = dev;
+	if (zonefs_get_wipe_chunks(&ctx, chunk_sectors) < 0)
+		return -1;
+
+	if (dev->flags & (ZONEFS_VERBOSE | ZONEFS_DRY_RUN))
+		fprintf(dev->out, "  Wipe plan: %llu MiB in %u chunk%s\n",
+			ctx.nr_sectors >> 11,
+			ctx.nr_chunks, ctx.nr_chunks > 1 ? "s" : "");
+
+	if (!ctx.nr_chunks || (dev->flags & ZONEFS_DRY_RUN)) {
+		free(ctx.chunks);
+		return 0;
+	}
+
+	pthread_mutex_init(&ctx.lock, NULL);
+	pthread_cond_init(&ctx.cond, NULL);
+	ctx.next_usec = zonefs_usec();
+
+	nr_workers = zonefs_nr_workers(dev, ctx.nr_chunks);
+	for (i = 0; i < nr_workers; i++) {
+		pthread_mutex_lock(&ctx.lock);
+		ctx.nr_running++;
+		pthread_mutex_unlock(&ctx.lock);
+
+		ret = pthread_create(&threads[i], NULL,
+				     zonefs_wipe_worker, &ctx);
+		if (ret) {
+			zonefs_set_error(dev, ret,
+				"%s: Create wipe thread failed %d (%s)",
+				dev->name, ret, strerror(ret));
+			pthread_mutex_lock(&ctx.lock);
+			ctx.nr_running--;
+			pthread_mutex_unlock(&ctx.lock);
+			if (!nr_threads) {
+				ctx.error = 1;
+				goto out;
+			}
+			break;
+		}
+		nr_threads++;
+	}
+
+	/* Wait for the workers, reporting progress every half second */
+	pthread_mutex_lock(&ctx.lock);
+	while (ctx.nr_running) {
+		clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_nsec += 500000000;
+		if (ts.tv_nsec >= 1000000000) {
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000000000;
+		}
+		pthread_cond_timedwait(&ctx.cond, &ctx.lock, &ts);
+		zonefs_wipe_progress(&ctx);
+	}
+	pthread_mutex_unlock(&ctx.lock);
+
+	for (i = 0; i < nr_threads; i++)
+		pthread_join(threads[i], NULL);
+
+	if (dev->flags & ZONEFS_PROGRESS)
+		fprintf(dev->out, "\n");
+
+out:
+	pthread_cond_destroy(&ctx.cond);
+	pthread_mutex_destroy(&ctx.lock);
+	free(ctx.chunks);
+
+	return ctx.error ? -1 : 0;
+}
+
+/*
+ * Wipe the conventional zones of a device, either zeroing them out or
+ * discarding them, using multiple threads. Read-only and offline zones are
+ * left untouched. In dry-run mode, only print the amount of data that would
+ * be wiped.
+ */
+int zonefs_wipe_cnv_zones(struct zonefs_dev *dev)
+{
+	unsigned long long start = zonefs_usec();
+	int ret;
+
+	zonefs_clear_error(dev);
+
+	if (dev->wipe == ZONEFS_WIPE_NONE)
+		return 0;
+
+	ret = __zonefs_wipe_cnv_zones(dev);
+	zonefs_phase_done(dev, ZONEFS_PHASE_CNV_WIPE, start);
+
+	return ret;
+}
@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * This file is part of zonefs tools.
+ * Copyright (c) 2026 Western Digital Corporation or its affiliates.
+ *
+ * Internal definitions of libzonefs and mkzonefs. This header is not
+ * installed.
+ */
+#ifndef ZONEFS_PRIV_H
+#define ZONEFS_PRIV_H
+
+#include "zonefs.h"
+
+#include <time.h>
+
+/*
+ * Maximum number of threads used for zone operations.
+ */
+#define ZONEFS_MAX_WORKERS	128
+
+#define zonefs_zone_id(dev, sector) \
+	(unsigned int)((sector) / (dev)->zone_nr_sectors)
+
+/*
+ * Zone table update.
+ */
+static inline void zonefs_zone_set_wp(struct zonefs_dev *dev,
+				      unsigned int zno, __u64 wp)
+{
+	dev->zones.wp_ofst[zno] = wp - zonefs_zone_start(dev, zno);
+}
+
+static inline void zonefs_zone_set_cond(struct zonefs_dev *dev,
+					unsigned int zno, unsigned int cond)
+{
+	dev->zones.cond[zno] = cond;
+}
+
+/*
+ * Monotonic clock in microseconds.
+ */
+static inline unsigned long long zonefs_usec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+/*
+ * Account the time spent in a phase since start.
+ */
+static inline void zonefs_phase_done(struct zonefs_dev *dev,
+				     enum zonefs_phase phase,
+				     unsigned long long start)
+{
+	dev->stats.phase_usec[phase] += zonefs_usec() - start;
+}
+
+/*
+ * Library call errors.
+ */
+static inline void zonefs_clear_error(struct zonefs_dev *dev)
+{
+	dev->err = 0;
+	dev->errmsg[0] = '\0';
+}
+
+void zonefs_set_error(struct zonefs_dev *dev, int err, const char *fmt, ...)
+	__attribute__ ((format (printf, 3, 4), visibility ("hidden")));
+
+/*
+ * For compile time checks
+ */
+#define ZONEFS_STATIC_ASSERT(cond) \
+	void zonefs_static_assert(int dummy[(cond) ? 1 : -1])
+
+#endif /* ZONEFS_PRIV_H */
@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * This file is part of zonefs tools.
+ * Copyright (c) 2019 Western Digital Corporation or its affiliates.
+ *
+ * Authors: Damien Le Moal (damien.lemoal@wdc.com)
+ */
+
+#include "config.h"
+#include "zonefs_priv.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <asm/byteorder.h>
+
+/*
+ * For super block checksum (CRC32)
+ */
+#define CRCPOLY_LE 0xedb88320
+
+__u32 zonefs_crc32(__u32 crc, const void *buf, size_t length)
+{
+	unsigned char *p = (unsigned char *)buf;
+	int i;
+
+	while (length--) {
+		crc ^= *p++;
+		for (i = 0; i < 8; i++)
+			crc = (crc >> 1) ^ ((crc & 1) ? CRCPOLY_LE : 0);
+	}
+
+	return crc;
+}
+
+/*
+ * Fill and write a super block.
+ */
+int zonefs_write_super(struct zonefs_dev *dev)
+{
+	unsigned long long start = zonefs_usec();
+	struct zonefs_super *super;
+	__u32 crc;
+	int ret;
+
+	zonefs_clear_error(dev);
+
+	ret = posix_memalign((void **)&super, sysconf(_SC_PAGESIZE),
+			     sizeof(*super));
+	if (ret) {
+		zonefs_set_error(dev, ENOMEM, "Not enough memory");
+		ret = -1;
+		goto out;
+	}
+
+	memset(super, 0, sizeof(*super));
+	super->s_magic = __cpu_to_le32(ZONEFS_MAGIC);
+	uuid_copy(super->s_uuid, dev->uuid);
+	strcpy(super->s_label, dev->label);
+	super->s_features = __cpu_to_le64(dev->features);
+	super->s_uid = __cpu_to_le32(dev->uid);
+	super->s_gid = __cpu_to_le32(dev->gid);
+	super->s_perm = __cpu_to_le32(dev->perm);
+
+	crc = zonefs_crc32(~0U, super, sizeof(*super));
+	super->s_crc = __cpu_to_le32(crc);
+
+	ret = pwrite(dev->fd, super, sizeof(*super), 0);
+	free(super);
+
+	if (ret < 0) {
+		zonefs_set_error(dev, errno,
+			"%s: Write super block failed %d (%s)",
+			dev->name, errno, strerror(errno));
+		ret = -1;
+		goto out;
+	}
+
+	ret = zonefs_finish_zone(dev, 0);
+
+out:
+	zonefs_phase_done(dev, ZONEFS_PHASE_SUPER, start);
+
+	return ret;
+}
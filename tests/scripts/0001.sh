@@ -19,6 +19,11 @@ OPTS_OK=(""
 	 "--help"
 	 "-v"
 	 "-f"
+	 "-j 1"
+	 "-j 4"
+	 "-i"
+	 "-i -j 4"
+	 "--stats"
 	 "-o aggr_cnv"
 	 "-o uid=0"
 	 "-o gid=0"
@@ -38,6 +43,11 @@ done
 # Test various bad mkzonefs options
 OPTS_BAD=("-bad-option"
 	  "-o"
+	  "-j 0"
+	  "--stats -n"
+	  "-w invalid"
+	  "-B 100"
+	  "-w zero -B 0"
 	  "-o invalid_feature"
 	  "-o invalid,,list")
 
@@ -0,0 +1,42 @@
+#!/bin/bash
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# Copyright (C) 2026 Western Digital Corporation or its affiliates.
+#
+
+. scripts/test_lib
+
+if [ $# == 0 ]; then
+	echo "mkzonefs (incremental format and dry run)"
+	exit 0
+fi
+
+zonefs_mkfs "$1"
+zonefs_mount "$1"
+
+echo "Write seq files 0 and 2"
+write_file "${zonefs_mntdir}/seq/0" 4096
+write_file "${zonefs_mntdir}/seq/2" 4096
+
+zonefs_umount
+
+# A dry run must not change anything
+echo "Check mkzonefs dry run"
+zonefs_mkfs "-n -i $1"
+
+zonefs_mount "$1"
+check_file_size "${zonefs_mntdir}/seq/0" 4096
+check_file_size "${zonefs_mntdir}/seq/2" 4096
+zonefs_umount
+
+# An incremental format must reset the written files
+echo "Check mkzonefs incremental format"
+zonefs_mkfs "-i $1"
+
+zonefs_mount "$1"
+check_file_size "${zonefs_mntdir}/seq/0" 0
+check_file_size "${zonefs_mntdir}/seq/2" 0
+zonefs_umount
+
+exit 0
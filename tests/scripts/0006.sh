@@ -0,0 +1,46 @@
+#!/bin/bash
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# Copyright (C) 2026 Western Digital Corporation or its affiliates.
+#
+
+. scripts/test_lib
+
+if [ $# == 0 ]; then
+	echo "mkzonefs (multiple devices)"
+	exit 0
+fi
+
+require_null_blk
+
+nulldev1=$(create_zoned_nullb)
+dev1="/dev/nullb${nulldev1}"
+nulldev2=$(create_zoned_nullb)
+dev2="/dev/nullb${nulldev2}"
+
+echo "Check mkzonefs with multiple devices"
+mkzonefs -f -P 2 "$dev1" "$dev2" || \
+	exit_failed " --> FAILED"
+
+echo "Check mkzonefs with a device list file"
+devlist="${logdir}/.zonefs_test_devlist"
+printf "# Test devices\n%s\n\n%s\n" "$dev1" "$dev2" > "$devlist"
+mkzonefs -f -D "$devlist" || \
+	exit_failed " --> FAILED"
+
+echo "Check mkzonefs with an invalid device in the device list"
+echo "/dev/console" >> "$devlist"
+mkzonefs -f -D "$devlist" && \
+	exit_failed " --> SUCCESS (should FAIL)"
+rm -f "$devlist"
+
+zonefs_mount "$dev1"
+zonefs_umount
+zonefs_mount "$dev2"
+zonefs_umount
+
+destroy_nullb $nulldev2
+destroy_nullb $nulldev1
+
+exit 0
@@ -0,0 +1,35 @@
+#!/bin/bash
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# Copyright (C) 2026 Western Digital Corporation or its affiliates.
+#
+
+. scripts/test_lib
+
+if [ $# == 0 ]; then
+	echo "mkzonefs (conventional zones wipe)"
+	exit 0
+fi
+
+require_cnv_files
+
+zonefs_mkfs "-o aggr_cnv $1"
+zonefs_mount "$1"
+
+echo "Write conventional file 0"
+dd if=/dev/urandom of="${zonefs_mntdir}/cnv/0" oflag=direct \
+	bs=1M count=1 conv=nocreat,notrunc || \
+	exit_failed " --> FAILED"
+
+zonefs_umount
+
+echo "Check mkzonefs conventional zones wipe"
+zonefs_mkfs "-w zero -B 1024 -o aggr_cnv $1"
+
+zonefs_mount "$1"
+cmp -n 1048576 "${zonefs_mntdir}/cnv/0" /dev/zero || \
+	exit_failed " --> Conventional file 0 not zeroed out"
+zonefs_umount
+
+exit 0
@@ -0,0 +1,45 @@
+#!/bin/bash
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# Copyright (C) 2026 Western Digital Corporation or its affiliates.
+#
+
+. scripts/test_lib
+
+if [ $# == 0 ]; then
+	echo "mkzonefs (pipelined zone reset errors)"
+	exit 0
+fi
+
+require_null_blk
+require_nullb_offline
+
+# Zoned device without conventional zones: zone 0 is sequential
+nulldev=$(create_zoned_nullb 0)
+dev="/dev/nullb${nulldev}"
+cfg="/sys/kernel/config/nullb/nullb${nulldev}"
+zone_sectors=$(( 32 * 1048576 / 512 ))
+
+echo "Write zone 0 and set all other zones offline"
+dd if=/dev/zero of="${dev}" bs=4096 oflag=direct count=1 || \
+	exit_failed " --> Write zone 0 FAILED"
+for (( zno=1; zno<64; zno++ )); do
+	echo $(( zno * zone_sectors )) > "${cfg}/zone_offline" || \
+		exit_failed " --> Set zone ${zno} offline FAILED"
+done
+zone0=$(zone_info "${dev}" 0)
+
+# The incremental format pipelines the zone report and reset: it must fail
+# on the device without usable zones and without resetting zone 0.
+echo "Check mkzonefs incremental format on a device without usable zones"
+mkzonefs -f -i "${dev}" && \
+	exit_failed " --> SUCCESS (should FAIL)"
+
+echo "Check that zone 0 was not reset"
+[ "$(zone_info "${dev}" 0)" == "${zone0}" ] || \
+	exit_failed " --> Zone 0 was reset"
+
+destroy_nullb ${nulldev}
+
+exit 0
@@ -0,0 +1,52 @@
+#!/bin/bash
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# Copyright (C) 2026 Western Digital Corporation or its affiliates.
+#
+
+. scripts/test_lib
+
+if [ $# == 0 ]; then
+	echo "Sequential file append (io_uring)"
+        exit 0
+fi
+
+echo "Check sequential file append (io_uring)"
+
+zonefs_mkfs "$1"
+zonefs_mount "$1"
+
+echo "Check io_uring append writes"
+
+tools/zio --write --fflag=direct --fflag=append --engine=uring --async=8 \
+	--size=$((2 * 1024 * 1024 )) "$zonefs_mntdir"/seq/0 || \
+	exit_failed " --> FAILED"
+
+sz=$(file_size "$zonefs_mntdir"/seq/0)
+[ "$sz" != "$seq_file_0_max_size" ] && \
+	exit_failed " --> Invalid file size $sz B, expected $seq_file_0_max_size B"
+
+echo "Check io_uring append writes with SQPOLL and fixed files"
+
+truncate --no-create --size=0 "$zonefs_mntdir"/seq/0 || \
+        exit_failed " --> FAILED"
+
+tools/zio --write --fflag=direct --fflag=append --engine=uring --async=8 \
+	--sqpoll --fixed-files \
+	--size=$((2 * 1024 * 1024 )) "$zonefs_mntdir"/seq/0 || \
+	exit_failed " --> FAILED"
+
+sz=$(file_size "$zonefs_mntdir"/seq/0)
+[ "$sz" != "$seq_file_0_max_size" ] && \
+	exit_failed " --> Invalid file size $sz B, expected $seq_file_0_max_size B"
+
+echo "Check io_uring reads"
+
+tools/zio --read --fflag=direct --engine=uring --async=8 \
+	--size=$((2 * 1024 * 1024 )) "$zonefs_mntdir"/seq/0 || \
+	exit_failed " --> FAILED"
+
+zonefs_umount
+
+exit 0
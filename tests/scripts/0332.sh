@@ -0,0 +1,40 @@
+#!/bin/bash
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# Copyright (C) 2026 Western Digital Corporation or its affiliates.
+#
+
+. scripts/test_lib
+
+if [ $# == 0 ]; then
+	echo "Sequential file append (async, batched completions)"
+        exit 0
+fi
+
+echo "Check sequential file append (async, batched completions)"
+
+zonefs_mkfs "$1"
+zonefs_mount "$1"
+
+for engine in aio uring; do
+
+	echo "Check $engine append writes with batched completions"
+
+	truncate --no-create --size=0 "$zonefs_mntdir"/seq/0 || \
+		exit_failed " --> FAILED"
+
+	tools/zio --write --fflag=direct --fflag=append \
+		--engine=$engine --async=16 --batch-min=4 --batch-max=8 \
+		--size=131072 "$zonefs_mntdir"/seq/0 || \
+		exit_failed " --> FAILED"
+
+	sz=$(file_size "$zonefs_mntdir"/seq/0)
+	[ "$sz" != "$seq_file_0_max_size" ] && \
+		exit_failed " --> Invalid file size $sz B, expected $seq_file_0_max_size B"
+
+done
+
+zonefs_umount
+
+exit 0
@@ -0,0 +1,50 @@
+#!/bin/bash
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# Copyright (C) 2026 Western Digital Corporation or its affiliates.
+#
+
+. scripts/test_lib
+
+if [ $# == 0 ]; then
+	echo "Sequential file IO latency histogram"
+        exit 0
+fi
+
+echo "Check sequential file IO latency histogram"
+
+zonefs_mkfs "$1"
+zonefs_mount "$1"
+
+tools/zio --write --fflag=direct --fflag=append --async=8 \
+	--size=$((1024 * 1024)) --nio=16 "$zonefs_mntdir"/seq/0 || \
+	exit_failed " --> FAILED"
+
+hist="/tmp/zio-lat-hist.$$"
+
+for engine in sync aio uring; do
+
+	echo "Check $engine engine read latency histogram"
+
+	if [ "$engine" == "sync" ]; then
+		async=""
+	else
+		async="--async=8"
+	fi
+
+	tools/zio --read --fflag=direct --engine=$engine $async \
+		--size=4096 --nio=1024 --lat-hist="$hist" \
+		"$zonefs_mntdir"/seq/0 || \
+		exit_failed " --> FAILED"
+
+	nr=$(grep -v '^#' "$hist" | awk '{ n += $3 } END { print n }')
+	rm -f "$hist"
+	[ "$nr" != "1024" ] && \
+		exit_failed " --> Invalid histogram count $nr, expected 1024"
+
+done
+
+zonefs_umount
+
+exit 0
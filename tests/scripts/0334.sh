@@ -0,0 +1,61 @@
+#!/bin/bash
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# Copyright (C) 2026 Western Digital Corporation or its affiliates.
+#
+
+. scripts/test_lib
+
+if [ $# == 0 ]; then
+	echo "Sequential files append (multiple jobs)"
+        exit 0
+fi
+
+echo "Check sequential files append (multiple jobs)"
+
+nrfiles=$(min 4 $nr_seq_files)
+max_open_zones=$(get_max_open_zones "$1")
+if [ "$max_open_zones" != 0 ]; then
+	nrfiles=$(min $nrfiles $max_open_zones)
+fi
+max_active_zones=$(get_max_active_zones "$1")
+if [ "$max_active_zones" != 0 ]; then
+	nrfiles=$(min $nrfiles $max_active_zones)
+fi
+
+zonefs_mkfs "$1"
+zonefs_mount "$1"
+
+for engine in sync aio uring; do
+
+	echo "Check $engine append writes to $nrfiles files with $nrfiles jobs"
+
+	if [ "$engine" == "sync" ]; then
+		async=""
+	else
+		async="--async=4"
+	fi
+
+	for (( i=0; i<nrfiles; i++ )); do
+		truncate --no-create --size=0 "$zonefs_mntdir"/seq/$i || \
+			exit_failed " --> FAILED"
+	done
+
+	tools/zio --write --fflag=direct --fflag=append \
+		--engine=$engine $async --size=131072 --nio=8 \
+		--jobs=$nrfiles --file-range=0-$(( nrfiles - 1 )) \
+		"$zonefs_mntdir"/seq || \
+		exit_failed " --> FAILED"
+
+	for (( i=0; i<nrfiles; i++ )); do
+		sz=$(file_size "$zonefs_mntdir"/seq/$i)
+		[ "$sz" != "1048576" ] && \
+			exit_failed " --> Invalid file seq/$i size $sz B, expected 1048576 B"
+	done
+
+done
+
+zonefs_umount
+
+exit 0
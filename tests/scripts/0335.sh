@@ -0,0 +1,47 @@
+#!/bin/bash
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# Copyright (C) 2026 Western Digital Corporation or its affiliates.
+#
+
+. scripts/test_lib
+
+if [ $# == 0 ]; then
+	echo "Sequential file append (multiple writers)"
+        exit 0
+fi
+
+echo "Check sequential file append (multiple writers)"
+
+zonefs_mkfs "$1"
+zonefs_mount "$1"
+
+for engine in sync aio uring; do
+
+	echo "Check $engine append writes with 4 writers"
+
+	if [ "$engine" == "sync" ]; then
+		async=""
+	else
+		async="--async=4"
+	fi
+
+	truncate --no-create --size=0 "$zonefs_mntdir"/seq/0 || \
+		exit_failed " --> FAILED"
+
+	# zio checks that the file size matches the amount of data written
+	tools/zio --write --fflag=direct --fflag=append \
+		--engine=$engine $async --size=131072 \
+		--jobs=4 --shared-file "$zonefs_mntdir"/seq/0 || \
+		exit_failed " --> FAILED"
+
+	sz=$(file_size "$zonefs_mntdir"/seq/0)
+	[ "$sz" -gt "$seq_file_0_max_size" ] && \
+		exit_failed " --> Invalid file size $sz B, max $seq_file_0_max_size B"
+
+done
+
+zonefs_umount
+
+exit 0
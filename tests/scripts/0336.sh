@@ -0,0 +1,65 @@
+#!/bin/bash
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# Copyright (C) 2026 Western Digital Corporation or its affiliates.
+#
+
+. scripts/test_lib
+
+if [ $# == 0 ]; then
+	echo "Sequential file append data verification"
+        exit 0
+fi
+
+echo "Check sequential file append data verification"
+
+zonefs_mkfs "$1"
+zonefs_mount "$1"
+
+for wengine in sync aio; do
+
+	if [ "$wengine" == "sync" ]; then
+		async=""
+	else
+		async="--async=16"
+	fi
+
+	truncate --no-create --size=0 "$zonefs_mntdir"/seq/0 || \
+		exit_failed " --> FAILED"
+
+	echo "Check $wengine append writes with verify data"
+
+	tools/zio --write --fflag=direct --fflag=append \
+		--engine=$wengine $async --size=131072 --verify=42 \
+		"$zonefs_mntdir"/seq/0 || \
+		exit_failed " --> FAILED"
+
+	for rengine in sync aio uring; do
+
+		echo "Check $rengine reads of $wengine append writes"
+
+		if [ "$rengine" == "sync" ]; then
+			async=""
+		else
+			async="--async=8"
+		fi
+
+		tools/zio --read --fflag=direct --engine=$rengine $async \
+			--size=65536 --iovec --verify=42 \
+			"$zonefs_mntdir"/seq/0 || \
+			exit_failed " --> FAILED"
+
+	done
+
+	echo "Check verify failure with a different seed"
+
+	tools/zio --read --fflag=direct --size=65536 --nio=1 --verify=43 \
+		"$zonefs_mntdir"/seq/0 > /dev/null 2>&1 && \
+		exit_failed " --> Verify succeeded (should fail)"
+
+done
+
+zonefs_umount
+
+exit 0
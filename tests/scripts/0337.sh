@@ -0,0 +1,47 @@
+#!/bin/bash
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# Copyright (C) 2026 Western Digital Corporation or its affiliates.
+#
+
+. scripts/test_lib
+
+if [ $# == 0 ]; then
+	echo "Sequential file rate limited reads"
+        exit 0
+fi
+
+echo "Check sequential file rate limited reads"
+
+zonefs_mkfs "$1"
+zonefs_mount "$1"
+
+tools/zio --write --fflag=direct --fflag=append --async=8 \
+	--size=$((1024 * 1024)) --nio=4 "$zonefs_mntdir"/seq/0 || \
+	exit_failed " --> FAILED"
+
+for engine in sync aio uring; do
+
+	echo "Check $engine engine reads at 2000 IOPS"
+
+	if [ "$engine" == "sync" ]; then
+		async=""
+	else
+		async="--async=4"
+	fi
+
+	# 200 IOs at 2000 IOPS cannot complete in less than 100 ms
+	ms=$(tools/zio --read --fflag=direct --engine=$engine $async \
+		--size=4096 --nio=200 --rate-iops=2000 \
+		"$zonefs_mntdir"/seq/0 | \
+		grep "IOs done in" | awk '{ print $5 }')
+	[ -z "$ms" ] && exit_failed " --> FAILED"
+	[ "$ms" -lt 99 ] && \
+		exit_failed " --> Run took $ms ms, expected at least 99 ms"
+
+done
+
+zonefs_umount
+
+exit 0
@@ -0,0 +1,53 @@
+#!/bin/bash
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# Copyright (C) 2026 Western Digital Corporation or its affiliates.
+#
+
+. scripts/test_lib
+
+if [ $# == 0 ]; then
+	echo "Sequential file random reads"
+        exit 0
+fi
+
+echo "Check sequential file random reads"
+
+zonefs_mkfs "$1"
+zonefs_mount "$1"
+
+tools/zio --write --fflag=direct --fflag=append --async=8 \
+	--size=$((1024 * 1024)) --nio=8 --verify \
+	"$zonefs_mntdir"/seq/0 || \
+	exit_failed " --> FAILED"
+
+for dist in uniform zipf zipf:0.5 hotspot hotspot:20:80; do
+	for engine in sync uring; do
+
+		if [ "$engine" == "sync" ]; then
+			async=""
+		else
+			async="--async=8"
+		fi
+
+		echo "Check $engine $dist direct random reads"
+
+		tools/zio --read --fflag=direct --engine=$engine $async \
+			--size=8192 --nio=2048 --rand=$dist --verify \
+			"$zonefs_mntdir"/seq/0 || \
+			exit_failed " --> FAILED"
+
+		echo "Check $engine $dist buffered random reads"
+
+		tools/zio --read --engine=$engine $async \
+			--size=8192 --nio=2048 --rand=$dist --verify \
+			"$zonefs_mntdir"/seq/0 || \
+			exit_failed " --> FAILED"
+
+	done
+done
+
+zonefs_umount
+
+exit 0
@@ -0,0 +1,45 @@
+#!/bin/bash
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# Copyright (C) 2026 Western Digital Corporation or its affiliates.
+#
+
+. scripts/test_lib
+
+if [ $# == 0 ]; then
+	echo "Sequential file time based wrap-around appends"
+        exit 0
+fi
+
+echo "Check sequential file time based wrap-around appends"
+
+zonefs_mkfs "$1"
+zonefs_mount "$1"
+
+last=$(( $(min $nr_seq_files 2) - 1 ))
+
+out=$(tools/zio --write --fflag=direct --fflag=append --async=4 \
+	--size=$((128 * 1024)) --runtime=2 --interval=0.5 --wrap \
+	--verify --file-range=0-$last "$zonefs_mntdir"/seq) || \
+	exit_failed " --> FAILED"
+
+# The run must last the run time and report every interval
+ms=$(echo "$out" | grep "IOs done in" | awk '{ print $5 }')
+[ -z "$ms" ] && exit_failed " --> FAILED"
+[ "$ms" -lt 1990 ] && \
+	exit_failed " --> Run took $ms ms, expected at least 1990 ms"
+
+nr=$(echo "$out" | grep -c "IOPS, .* MB/s, p50")
+[ "$nr" -lt 4 ] && \
+	exit_failed " --> $nr interval reports, expected at least 4"
+
+echo "Check data"
+
+tools/zio --read --fflag=direct --size=$((128 * 1024)) --verify \
+	--file-range=0-$last "$zonefs_mntdir"/seq || \
+	exit_failed " --> FAILED"
+
+zonefs_umount
+
+exit 0
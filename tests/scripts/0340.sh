@@ -0,0 +1,59 @@
+#!/bin/bash
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# Copyright (C) 2026 Western Digital Corporation or its affiliates.
+#
+
+. scripts/test_lib
+
+if [ $# == 0 ]; then
+	echo "Sequential file JSON and CSV result output"
+        exit 0
+fi
+
+echo "Check sequential file JSON and CSV result output"
+
+zonefs_mkfs "$1"
+zonefs_mount "$1"
+
+tools/zio --write --fflag=direct --fflag=append --async=8 \
+	--size=$((1024 * 1024)) --nio=4 "$zonefs_mntdir"/seq/0 || \
+	exit_failed " --> FAILED"
+
+echo "Check JSON output"
+
+out=$(tools/zio --read --fflag=direct --size=4096 --nio=256 \
+	--output-format=json "$zonefs_mntdir"/seq/0) || \
+	exit_failed " --> FAILED"
+
+echo "$out" | head -n 1 | grep -q "^{$" || \
+	exit_failed " --> Invalid JSON output"
+echo "$out" | grep -q "\"engine\": \"sync\"" || \
+	exit_failed " --> No engine in JSON output"
+echo "$out" | grep -q "\"fflags\": \[\"direct\"\]" || \
+	exit_failed " --> No file flags in JSON output"
+echo "$out" | grep -q "\"ios\": 256," || \
+	exit_failed " --> Invalid number of IOs in JSON output"
+
+echo "Check CSV output"
+
+out=$(tools/zio --read --fflag=direct --size=4096 --nio=256 \
+	--rate-iops=2000 --interval=0.02 --output-format=csv \
+	"$zonefs_mntdir"/seq/0) || \
+	exit_failed " --> FAILED"
+
+echo "$out" | head -n 1 | grep -q "^type,rw,engine," || \
+	exit_failed " --> No CSV header"
+ios=$(echo "$out" | grep "^total," | cut -d "," -f 14)
+[ "$ios" != "256" ] && \
+	exit_failed " --> Invalid number of IOs in CSV output ($ios)"
+
+# 256 IOs at 2000 IOPS take 128 ms, that is at least 6 intervals
+nr=$(echo "$out" | grep -c "^interval,")
+[ "$nr" -lt 6 ] && \
+	exit_failed " --> $nr interval rows, expected at least 6"
+
+zonefs_umount
+
+exit 0
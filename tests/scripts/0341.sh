@@ -0,0 +1,55 @@
+#!/bin/bash
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# Copyright (C) 2026 Western Digital Corporation or its affiliates.
+#
+
+. scripts/test_lib
+
+if [ $# == 0 ]; then
+	echo "Sequential file polled direct reads"
+        exit 0
+fi
+
+echo "Check sequential file polled direct reads"
+
+zonefs_mkfs "$1"
+zonefs_mount "$1"
+
+tools/zio --write --fflag=direct --fflag=append --async=8 \
+	--size=$((1024 * 1024)) --nio=4 "$zonefs_mntdir"/seq/0 || \
+	exit_failed " --> FAILED"
+
+# Polling requires a device with poll queues
+tools/zio --read --fflag=direct --engine=uring --async=1 --poll \
+	--size=4096 --nio=1 "$zonefs_mntdir"/seq/0 > /dev/null 2>&1 || \
+	exit_skip "Polled IOs not supported"
+
+for poll in none busy hybrid; do
+
+	echo "Check $poll polling reads"
+
+	if [ "$poll" == "none" ]; then
+		opt=""
+	else
+		opt="--poll=$poll"
+	fi
+
+	out=$(tools/zio --read --fflag=direct --engine=uring --async=4 \
+		$opt --size=4096 --nio=1024 "$zonefs_mntdir"/seq/0)
+	if [ $? != 0 ]; then
+		# Hybrid polling requires kernel 6.13 or later
+		[ "$poll" == "hybrid" ] && continue
+		exit_failed " --> FAILED"
+	fi
+
+	# Compare latency and CPU cost per IO with interrupts
+	echo "$out" | grep "engine"
+	echo "$out" | grep "Latency"
+
+done
+
+zonefs_umount
+
+exit 0
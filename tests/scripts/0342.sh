@@ -0,0 +1,51 @@
+#!/bin/bash
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# Copyright (C) 2026 Western Digital Corporation or its affiliates.
+#
+
+. scripts/test_lib
+
+if [ $# == 0 ]; then
+	echo "Sequential file IOs with huge page and fixed buffers"
+        exit 0
+fi
+
+echo "Check sequential file IOs with huge page and fixed buffers"
+
+zonefs_mkfs "$1"
+zonefs_mount "$1"
+
+echo "Check writes with registered transparent huge page buffers"
+
+tools/zio --write --fflag=direct --fflag=append --engine=uring --async=8 \
+	--size=$((128 * 1024)) --nio=64 --mem=thp --fixed-bufs --verify \
+	"$zonefs_mntdir"/seq/0 || \
+	exit_failed " --> FAILED"
+
+mems="malloc thp"
+if [ "$(cat /proc/sys/vm/nr_hugepages)" -gt 0 ]; then
+	mems="$mems hugetlb"
+fi
+
+for mem in $mems; do
+	for fixed in "" "--fixed-bufs"; do
+
+		echo "Check reads with $mem buffers $fixed"
+
+		out=$(tools/zio --read --fflag=direct --engine=uring \
+			--async=8 --size=$((128 * 1024)) --mem=$mem $fixed \
+			--verify "$zonefs_mntdir"/seq/0) || \
+			exit_failed " --> FAILED"
+
+		# Compare throughput and CPU cost with malloc buffers
+		echo "$out" | grep "IOPS"
+		echo "$out" | grep "engine"
+
+	done
+done
+
+zonefs_umount
+
+exit 0
@@ -0,0 +1,52 @@
+#!/bin/bash
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# Copyright (C) 2026 Western Digital Corporation or its affiliates.
+#
+
+. scripts/test_lib
+
+if [ $# == 0 ]; then
+	echo "Sequential file IOs with CPU and NUMA placement"
+        exit 0
+fi
+
+echo "Check sequential file IOs with CPU and NUMA placement"
+
+zonefs_mkfs "$1"
+zonefs_mount "$1"
+
+tools/zio --write --fflag=direct --fflag=append --async=8 \
+	--size=$((1024 * 1024)) --nio=4 "$zonefs_mntdir"/seq/0 || \
+	exit_failed " --> FAILED"
+
+# Use the device NUMA node, or node 0 if the device has none
+node=$(cat /sys/block/$(devname "$1")/device/numa_node 2>/dev/null)
+if [ -z "$node" ] || [ "$node" -lt 0 ]; then
+	node=0
+fi
+cpu=$(cut -d ',' -f 1 /sys/devices/system/node/node$node/cpulist | \
+	cut -d '-' -f 1)
+
+echo "Check reads on node $node CPU $cpu"
+
+out=$(tools/zio --read --fflag=direct --async=4 --size=4096 \
+	--numa-node=$node --cpus=$cpu "$zonefs_mntdir"/seq/0) || \
+	exit_failed " --> FAILED"
+
+echo "$out" | grep "Device"
+echo "$out" | grep -q "Job 0 placement: CPU $cpu" || \
+	exit_failed " --> Job did not run on CPU $cpu"
+
+echo "Check reads on per-job CPU lists"
+
+nr_cpus=$(nproc)
+tools/zio --read --fflag=direct --size=4096 --jobs=2 \
+	--cpus=0:$((nr_cpus - 1)) --file-range=0-1 "$zonefs_mntdir"/seq > \
+	/dev/null || \
+	exit_failed " --> FAILED"
+
+zonefs_umount
+
+exit 0
@@ -0,0 +1,53 @@
+#!/bin/bash
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# Copyright (C) 2026 Western Digital Corporation or its affiliates.
+#
+
+. scripts/test_lib
+
+if [ $# == 0 ]; then
+	echo "Sequential file mmap engine reads"
+        exit 0
+fi
+
+echo "Check sequential file mmap engine reads"
+
+zonefs_mkfs "$1"
+zonefs_mount "$1"
+
+tools/zio --write --fflag=direct --fflag=append --async=8 \
+	--size=$((1024 * 1024)) --nio=8 --verify "$zonefs_mntdir"/seq/0 || \
+	exit_failed " --> FAILED"
+
+echo "Check preadv2 reads"
+
+tools/zio --read --size=$((128 * 1024)) --verify \
+	"$zonefs_mntdir"/seq/0 | grep "IOPS" || \
+	exit_failed " --> FAILED"
+
+for mode in copy checksum; do
+	for madv in sequential willneed hugepage; do
+
+		echo "Check mmap $mode reads, $madv hint"
+
+		echo 1 > /proc/sys/vm/drop_caches
+		tools/zio --read --engine=mmap --size=$((128 * 1024)) \
+			--mmap-read=$mode --madvise=$madv --verify \
+			"$zonefs_mntdir"/seq/0 | grep "IOPS" || \
+			exit_failed " --> FAILED"
+
+	done
+
+	echo "Check mmap $mode random page reads"
+
+	tools/zio --read --engine=mmap --size=4096 --rand=uniform \
+		--mmap-read=$mode --madvise=random --verify \
+		"$zonefs_mntdir"/seq/0 > /dev/null || \
+		exit_failed " --> FAILED"
+done
+
+zonefs_umount
+
+exit 0
@@ -0,0 +1,64 @@
+#!/bin/bash
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# Copyright (C) 2026 Western Digital Corporation or its affiliates.
+#
+
+. scripts/test_lib
+
+if [ $# == 0 ]; then
+	echo "Sequential file buffered read readahead sweep"
+        exit 0
+fi
+
+echo "Check sequential file buffered read readahead sweep"
+
+zonefs_mkfs "$1"
+zonefs_mount "$1"
+
+tools/zio --write --fflag=direct --fflag=append --async=8 \
+	--size=$((1024 * 1024)) --nio=8 --verify "$zonefs_mntdir"/seq/0 || \
+	exit_failed " --> FAILED"
+
+for hint in none sequential random; do
+
+	echo "Check cold reads, $hint hint"
+
+	tools/zio --read --size=$((64 * 1024)) --evict --ra-hint=$hint \
+		--verify "$zonefs_mntdir"/seq/0 | grep "Page cache" || \
+		exit_failed " --> FAILED"
+
+done
+
+echo "Check warm reads"
+
+out=$(tools/zio --read --size=$((64 * 1024)) --ra-hint=none \
+	--output-format=json "$zonefs_mntdir"/seq/0) || \
+	exit_failed " --> FAILED"
+hits=$(echo "$out" | grep "\"cache_hits\"" | tr -dc "0-9")
+lookups=$(echo "$out" | grep "\"cache_lookups\"" | tr -dc "0-9")
+[ "$hits" != "$lookups" ] && \
+	exit_failed " --> Warm reads missed the page cache ($hits / $lookups)"
+
+for hint in willneed readahead; do
+
+	echo "Check $hint readahead window sweep"
+
+	out=$(tools/zio --read --size=$((64 * 1024)) --ra-hint=$hint \
+		--ra-sweep=$((128 * 1024))-$((1024 * 1024)) --verify \
+		--output-format=csv "$zonefs_mntdir"/seq/0) || \
+		exit_failed " --> FAILED"
+
+	nr=$(echo "$out" | grep -c "^cold,")
+	[ "$nr" != "4" ] && \
+		exit_failed " --> $nr cold passes, expected 4"
+	nr=$(echo "$out" | grep -c "^warm,")
+	[ "$nr" != "4" ] && \
+		exit_failed " --> $nr warm passes, expected 4"
+
+done
+
+zonefs_umount
+
+exit 0
@@ -0,0 +1,50 @@
+#!/bin/bash
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# Copyright (C) 2026 Western Digital Corporation or its affiliates.
+#
+
+. scripts/test_lib
+
+if [ $# == 0 ]; then
+	echo "Conventional file random overwrite (aggr_cnv, zio)"
+        exit 0
+fi
+
+require_cnv_files
+
+echo "Check conventional file, aggr_cnv random overwrite"
+
+zonefs_mkfs "-o aggr_cnv $1"
+zonefs_mount "$1"
+
+wset=$((16 * 1024 * 1024))
+
+tools/zio --write --fflag=direct --size=$((1024 * 1024)) --nio=16 \
+	--verify "$zonefs_mntdir"/cnv/0 || \
+	exit_failed " --> FAILED"
+
+for sync in "" "--fflag=dsync" "--ioflag=dsync"; do
+	for dist in uniform zipf hotspot; do
+
+		echo "Check $dist random overwrite $sync"
+
+		tools/zio --write --fflag=direct $sync --engine=uring \
+			--async=8 --size=8192 --align=4096 --wset=$wset \
+			--nio=2048 --rand=$dist --verify \
+			"$zonefs_mntdir"/cnv/0 || \
+			exit_failed " --> FAILED"
+
+	done
+done
+
+echo "Check data after random overwrite"
+
+tools/zio --read --fflag=direct --size=$((1024 * 1024)) --nio=16 \
+	--verify "$zonefs_mntdir"/cnv/0 || \
+	exit_failed " --> FAILED"
+
+zonefs_umount
+
+exit 0
@@ -4,83 +4,7 @@
  * Author: Damien Le Moal <damien.lemoal@wdc.com>
  */
 
-#ifndef _GNU_SOURCE
-#define _GNU_SOURCE
-#endif
-
-#include <stdio.h>
-#include <stdlib.h>
-#include <stdbool.h>
-#include <unistd.h>
-#include <errno.h>
-#include <string.h>
-#include <sys/types.h>
-#include <sys/time.h>
-#include <sys/stat.h>
-#include <sys/uio.h>
-#include <sys/syscall.h>
-#include <fcntl.h>
-#include <linux/aio_abi.h>
-#include <linux/fs.h>
-
-/*
- * IO descriptor.
- */
-struct zio {
-	int nr;
-	void *buf;
-	struct iovec *iov;
-        struct iocb iocb;
-};
-
-/*
- * Run parameters.
- */
-struct zio_params {
-	bool verbose;
-	int fd;
-
-	bool read;
-	bool iovec;
-	bool async;
-
-	int fflags;
-	bool append;
-	loff_t fsize;
-	loff_t fmaxsize;
-	size_t blksize;
-
-	size_t iosize;
-	loff_t ioofst;
-	unsigned int iovcnt;
-	unsigned int iovlen;
-	unsigned int ionum;
-	int ioflags;
-	unsigned int iodepth;
-	struct zio *io;
-
-	aio_context_t ioctx;
-        struct iocb **iocbs;
-
-	unsigned int nr_ios;
-};
-
-/*
- * Utilities.
- */
-#define zio_vprintf(zio,format,args...)		\
-	if ((zio)->verbose) {			\
-                printf(format, ## args);	\
-        }
-
-static inline unsigned long long zio_usec(void)
-{
-	struct timeval tv;
-
-	gettimeofday(&tv, NULL);
-
-	return tv.tv_sec * 1000000ULL + tv.tv_usec;
-}
+#include "zio.h"
 
 /*
  * System call wrappers.
@@ -119,13 +43,18 @@ static inline int io_getevents(aio_context_t ctx, long min_nr, long max_nr,
 	return syscall(__NR_io_getevents, ctx, min_nr, max_nr, events, timeout);
 }
 
-static inline bool zio_done(struct zio_params *zio)
+/*
+ * Sleep until the monotonic clock reaches ns.
+ */
+void zio_wait_until(unsigned long long ns)
 {
-	if (zio->ionum)
-		return zio->nr_ios >= zio->ionum;
+	struct timespec ts;
 
-	return (zio->read && zio->ioofst >= zio->fsize) ||
-		(!zio->read && zio->ioofst >= zio->fmaxsize);
+	ts.tv_sec = ns / 1000000000ULL;
+	ts.tv_nsec = ns % 1000000000ULL;
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) ==
+	       EINTR)
+		;
 }
 
 /*
@@ -133,10 +62,23 @@ static inline bool zio_done(struct zio_params *zio)
  */
 static int zio_run_sync(struct zio_params *zio)
 {
+	struct zio *io = &zio->io[0];
+	unsigned long long now;
 	ssize_t ret;
 	loff_t ofst;
 
 	while (!zio_done(zio)) {
+		zio_next_ofst(zio);
+		if (zio->verify && !zio->read)
+			zio_verify_fill(zio, io, zio->ioofst);
+		if (zio->rate_ns) {
+			io->issue_ns = zio_rate_next(zio);
+			zio_wait_until(io->issue_ns);
+		}
+		if (zio->read && zio->cache_stats &&
+		    zio_cache_prep_read(zio, zio->ioofst, zio->iosize))
+			return -1;
+		zio_io_issue(zio, io, zio_nsec());
 		if (zio->read) {
 			ofst = zio->ioofst;
 			ret = preadv2(zio->fd, zio->io[0].iov, zio->iovcnt,
@@ -149,6 +91,8 @@ static int zio_run_sync(struct zio_params *zio)
 			ret = pwritev2(zio->fd, zio->io[0].iov, zio->iovcnt,
 				       ofst, zio->ioflags);
 		}
+		zio->nr_syscalls++;
+		now = zio_nsec();
 
 		if (ret <= 0) {
 			fprintf(stderr,
@@ -161,6 +105,10 @@ static int zio_run_sync(struct zio_params *zio)
 			return errno;
 		}
 
+		zio_io_done(zio, io, now);
+		if (zio->verify && zio->read)
+			zio_verify_check(zio, io, zio->ioofst, ret);
+
 		zio_vprintf(zio, "%05u: %s %zu B at %ld (%u vector%s) -> %zd B done\n",
 			    zio->nr_ios,
 			    zio->read ? "READ" : "WRITE",
@@ -178,125 +126,157 @@ static int zio_run_sync(struct zio_params *zio)
 /*
  * Async IO run.
  */
-static int zio_submit_async(struct zio_params *zio)
+static void zio_prep_async(struct zio_params *zio, struct zio *io)
 {
-	struct iocb *iocb;
-	struct zio *io;
-	unsigned int i, n = 0;
-	int ret;
-
-	for (i = 0; i < zio->iodepth; i++) {
-		if (zio_done(zio))
-			break;
+	struct iocb *iocb = &io->iocb;
 
-		io = &zio->io[i];
-		if (io->nr >= 0)
-			continue;
+	zio_next_ofst(zio);
 
-		iocb = &io->iocb;
-		memset(iocb, 0, sizeof(struct iocb));
-		iocb->aio_fildes = zio->fd;
-		if (zio->read) {
-			iocb->aio_lio_opcode = IOCB_CMD_PREAD;
+	memset(iocb, 0, sizeof(struct iocb));
+	iocb->aio_fildes = zio->fd;
+	if (zio->read) {
+		iocb->aio_lio_opcode = IOCB_CMD_PREAD;
+		iocb->aio_offset = zio->ioofst;
+	} else {
+		iocb->aio_lio_opcode = IOCB_CMD_PWRITE;
+		if (zio->append)
+			iocb->aio_offset = 0;
+		else
 			iocb->aio_offset = zio->ioofst;
-		} else {
-			iocb->aio_lio_opcode = IOCB_CMD_PWRITE;
-			if (zio->append)
-				iocb->aio_offset = 0;
-			else
-				iocb->aio_offset = zio->ioofst;
-		}
+	}
+	if (zio->iovec) {
+		iocb->aio_lio_opcode = zio->read ?
+			IOCB_CMD_PREADV : IOCB_CMD_PWRITEV;
+		iocb->aio_buf = (unsigned long)io->iov;
+		iocb->aio_nbytes = zio->iovcnt;
+	} else {
 		iocb->aio_buf = (unsigned long)io->buf;
 		iocb->aio_nbytes = zio->iosize;
-		iocb->aio_rw_flags = zio->ioflags;
-		iocb->aio_data = (unsigned long)io;
-
-		io->nr = zio->nr_ios;
-
-		zio_vprintf(zio, "%05d: %s %zu B at %ld issued\n",
-			    io->nr,
-			    zio->read ? "READ" : "WRITE",
-			    zio->iosize, zio->ioofst);
+	}
+	iocb->aio_rw_flags = zio->ioflags;
+	iocb->aio_data = (unsigned long)io;
+
+	io->nr = zio->nr_ios;
+	io->ofst = iocb->aio_offset;
+	io->issue_ns = zio_rate_next(zio);
+	if (zio->verify && !zio->read)
+		zio_verify_fill(zio, io, zio->ioofst);
+
+	zio_vprintf(zio, "%05d: %s %zu B at %ld issued\n",
+		    io->nr,
+		    zio->read ? "READ" : "WRITE",
+		    zio->iosize, zio->ioofst);
+
+	zio->nr_ios++;
+	zio->ioofst += zio->iosize;
+}
 
-		zio->iocbs[n] = iocb;
-		n++;
-		zio->nr_ios++;
+static int zio_submit_async(struct zio_params *zio, int nr)
+{
+	unsigned long long now = zio_nsec();
+	struct zio *io;
+	int ret, n;
 
-		zio->ioofst += zio->iosize;
+	for (n = 0; n < nr; n++) {
+		io = (struct zio *)(unsigned long)zio->iocbs[n]->aio_data;
+		zio_io_issue(zio, io, now);
 	}
 
-	if (!n)
-		return 0;
-
-	ret = io_submit(zio->ioctx, n, zio->iocbs);
-	if (ret < 0) {
-		fprintf(stderr, "io_submit failed %d (%s)\n",
-			errno, strerror(errno));
-		return -1;
+	n = 0;
+	while (n < nr) {
+		zio->nr_syscalls++;
+		ret = io_submit(zio->ioctx, nr - n, zio->iocbs + n);
+		if (ret < 0) {
+			if (errno == EINTR || errno == EAGAIN)
+				continue;
+			fprintf(stderr, "io_submit failed %d (%s)\n",
+				errno, strerror(errno));
+			return -1;
+		}
+		n += ret;
 	}
 
-	return n;
+	return nr;
 }
 
-static int zio_check_async(struct zio_params *zio,
-			   int submitted, int in_flight)
+/*
+ * Reap completed IOs in batches of at least batch_min and at most
+ * batch_max IOs, waiting at most timeout_ns if timeout_ns is not 0.
+ */
+static int zio_reap_async(struct zio_params *zio, int *in_flight,
+			  unsigned long long timeout_ns)
 {
-	struct io_event ioevent;
+	struct timespec ts, *timeout = NULL;
+	unsigned long long now;
+	struct io_event *ev;
 	struct iocb *iocb;
 	struct zio *io;
-	int ret, min_nr, n = 0;
+	int i, ret, min_nr, max_nr;
 
-	while (n < in_flight) {
-
-		if (!submitted || (in_flight - n) >= (int)zio->iodepth)
-			min_nr = 1;
-		else
-			min_nr = 0;
-
-		ret = io_getevents(zio->ioctx, min_nr, 1, &ioevent, NULL);
-		if (!ret)
-			break;
+	if (timeout_ns) {
+		ts.tv_sec = timeout_ns / 1000000000ULL;
+		ts.tv_nsec = timeout_ns % 1000000000ULL;
+		timeout = &ts;
+	}
 
-		if (ret != 1) {
-			fprintf(stderr, "io_getevents failed %d (%s)\n",
-				ret, strerror(ret));
-			return -1;
-		}
+	min_nr = zio->batch_min;
+	if (min_nr > *in_flight)
+		min_nr = *in_flight;
+	max_nr = zio->batch_max;
+	if (max_nr > *in_flight)
+		max_nr = *in_flight;
+
+	do {
+		zio->nr_syscalls++;
+		ret = io_getevents(zio->ioctx, min_nr, max_nr,
+				   zio->events, timeout);
+	} while (ret < 0 && errno == EINTR);
+	if (ret < 0) {
+		fprintf(stderr, "io_getevents failed %d (%s)\n",
+			errno, strerror(errno));
+		return -1;
+	}
 
-		iocb = (struct iocb *) ioevent.obj;
-		io = (struct zio *)ioevent.data;
+	now = zio_nsec();
+	for (i = 0; i < ret; i++) {
+		ev = &zio->events[i];
+		iocb = (struct iocb *) ev->obj;
+		io = (struct zio *)ev->data;
 
-		if (ioevent.res < 0) {
-			ret = -ioevent.res;
-			fprintf(stderr, "%05d: %s %llu B at %lld failed %d (%s)\n",
+		if (ev->res < 0) {
+			fprintf(stderr, "%05d: %s %zu B at %lld failed %d (%s)\n",
 				io->nr,
 				zio->read ? "READ" : "WRITE",
-				iocb->aio_nbytes, iocb->aio_offset,
-				ret, strerror(ret));
+				zio->iosize, iocb->aio_offset,
+				(int)-ev->res, strerror(-ev->res));
 			return -1;
 		}
 
-		zio_vprintf(zio, "%05d: %s %llu B at %lld completed\n",
+		zio_vprintf(zio, "%05d: %s %zu B at %lld completed\n",
 			    io->nr,
 			    zio->read ? "READ" : "WRITE",
-			    iocb->aio_nbytes, iocb->aio_offset);
+			    zio->iosize, iocb->aio_offset);
 
+		zio_io_done(zio, io, now);
+		if (zio->verify && zio->read)
+			zio_verify_check(zio, io, io->ofst, ev->res);
 		io->nr = -1;
-		n++;
 	}
 
-	return n;
+	*in_flight -= ret;
+
+	return 0;
 }
 
 static int zio_run_async(struct zio_params *zio)
 {
-	struct io_event ioevent;
-	int n, in_flight = 0;
-	ssize_t ret;
+	unsigned long long now, next, timeout;
+	int n, in_flight;
+	unsigned int i;
+	int ret;
 
 	/* Setup IO context */
 	memset(&zio->ioctx, 0, sizeof(aio_context_t));
-	memset(&ioevent, 0, sizeof(struct io_event));
 	ret = io_setup(zio->iodepth, &zio->ioctx);
         if (ret < 0) {
                 fprintf(stderr, "io_setup failed %d (%s)\n",
@@ -304,27 +284,52 @@ static int zio_run_async(struct zio_params *zio)
                 return -1;
         }
 
-	/* Do IOs until submission stops */
+	in_flight = 0;
 	while (1) {
+		/*
+		 * Prepare the next IOs in all free IO slots, or only the IOs
+		 * that are due with a rate limit, and submit them together.
+		 */
+		now = zio_nsec();
+		n = 0;
+		for (i = 0; i < zio->iodepth; i++) {
+			if (zio_done(zio) || !zio_io_due(zio, now))
+				break;
+			if (zio->io[i].nr >= 0)
+				continue;
+			zio_prep_async(zio, &zio->io[i]);
+			zio->iocbs[n++] = &zio->io[i].iocb;
+		}
 
-		n = zio_submit_async(zio);
+		n = zio_submit_async(zio, n);
 		if (n < 0) {
 			ret = -1;
 			break;
 		}
-
-		if (!n && !in_flight)
-			break;
-
 		in_flight += n;
 
-		n = zio_check_async(zio, n, in_flight);
-		if (n < 0) {
-			ret = -1;
-			break;
+		if (!in_flight) {
+			if (zio_done(zio))
+				break;
+			zio_wait_until(zio_rate_next(zio));
+			continue;
 		}
 
-		in_flight -= n;
+		/*
+		 * With a rate limit, do not wait for completions past the
+		 * time the next IO is due if an IO slot is free.
+		 */
+		timeout = 0;
+		if (zio->rate_ns && !zio_done(zio) &&
+		    in_flight < (int)zio->iodepth) {
+			next = zio_rate_next(zio);
+			now = zio_nsec();
+			timeout = next > now ? next - now : 1;
+		}
+
+		ret = zio_reap_async(zio, &in_flight, timeout);
+		if (ret)
+			break;
 	}
 
 	io_destroy(zio->ioctx);
@@ -336,21 +341,28 @@ static void zio_cleanup(struct zio_params *zio)
 {
 	unsigned int i;
 
+	zio_cache_cleanup(zio);
+
+	if (zio->fd >= 0) {
+		close(zio->fd);
+		zio->fd = -1;
+	}
+
 	if (!zio->io)
 		return;
 
-	for (i = 0; i < zio->iodepth; i++)
-		free(zio->io[i].buf);
+	for (i = 0; i < zio->iodepth; i++) {
+		if (!zio->pool)
+			free(zio->io[i].buf);
+		free(zio->io[i].iov);
+	}
 	free(zio->io);
 	zio->io = NULL;
 
 	free(zio->iocbs);
 	zio->iocbs = NULL;
-
-	if (zio->fd > 0) {
-		close(zio->fd);
-		zio->fd = -1;
-	}
+	free(zio->events);
+	zio->events = NULL;
 }
 
 static int zio_init_io(struct zio_params *zio, int idx)
@@ -362,12 +374,16 @@ static int zio_init_io(struct zio_params *zio, int idx)
 
 	io->nr = -1;
 
-	ret = posix_memalign((void **) &io->buf, zio->blksize,
-			     zio->iovlen * zio->iovcnt * 2);
-	if (ret != 0) {
-		fprintf(stderr, "Allocate IO buffer failed %d (%s)\n",
-			-ret, strerror(-ret));
-		return -1;
+	if (zio->pool) {
+		io->buf = zio_pool_slot(zio->pool, idx);
+	} else {
+		ret = posix_memalign((void **) &io->buf, zio->blksize,
+				     zio->buf_size);
+		if (ret != 0) {
+			fprintf(stderr, "Allocate IO buffer failed %d (%s)\n",
+				-ret, strerror(-ret));
+			return -1;
+		}
 	}
 
 	/* Allocate and initialize iovec array */
@@ -399,6 +415,7 @@ static int zio_init(struct zio_params *zio, char *path)
 	int ret;
 
 	/* Open file */
+	zio->path = path;
 	zio->fd = open(path, zio->fflags, 0);
 	if (zio->fd < 0) {
 		fprintf(stderr, "Open %s failed %d (%s)\n",
@@ -415,6 +432,7 @@ static int zio_init(struct zio_params *zio, char *path)
 	zio->fsize = st.st_size;
 	zio->fmaxsize = st.st_blocks << 9;
 	zio->blksize = st.st_blksize;
+	zio->ino = st.st_ino;
 
 	/* If we do append writes, set offset to EOF */
 	if (!zio->read) {
@@ -425,6 +443,17 @@ static int zio_init(struct zio_params *zio, char *path)
 			zio->ioofst = zio->fsize;
 	}
 
+	/* With --wrap, restart appending to full files from the start */
+	if (zio->wrap && zio->append && zio->fsize >= zio->fmaxsize) {
+		if (ftruncate(zio->fd, 0)) {
+			fprintf(stderr, "Truncate %s failed %d (%s)\n",
+				path, errno, strerror(errno));
+			goto err;
+		}
+		zio->fsize = 0;
+		zio->ioofst = 0;
+	}
+
 	/* Allocate and initialize IO array */
 	if (zio->iovec) {
 		zio->iovlen = sysconf(_SC_PAGESIZE);
@@ -433,6 +462,21 @@ static int zio_init(struct zio_params *zio, char *path)
 		zio->iovlen = zio->iosize;
 		zio->iovcnt = 1;
 	}
+	if (zio->rand && zio_rand_init(zio, zio->fsize))
+		goto err;
+
+	if (zio->verify && zio_verify_init(zio))
+		goto err;
+
+	/* Without a buffer pool, IO buffers are allocated per IO slot */
+	zio->buf_size = zio->iovlen * zio->iovcnt * 2;
+	if (zio->pool) {
+		if (zio_pool_alloc(zio->pool, zio->mem, zio->buf_size,
+				   zio->iodepth))
+			goto err;
+		zio->buf_size = zio->pool->slot_size;
+	}
+
 	zio->io = calloc(zio->iodepth, sizeof(struct zio));
 	if (!zio->io) {
 		fprintf(stderr, "No memory for IO array\n");
@@ -446,135 +490,1437 @@ static int zio_init(struct zio_params *zio, char *path)
 	}
 
 	zio->iocbs = calloc(zio->iodepth, sizeof(struct iocb *));
-	if (!zio->iocbs) {
+	zio->events = calloc(zio->iodepth, sizeof(struct io_event));
+	if (!zio->iocbs || !zio->events) {
 		fprintf(stderr, "No memory for async IO array\n");
 		goto err;
 	}
 
+	if (zio->read && (zio->evict || zio->cache_stats) &&
+	    zio_cache_init(zio))
+		goto err;
+
 	return 0;
 
 err:
+	/* The job stops: do not keep its buffer pool for the next file */
+	if (zio->pool)
+		zio_pool_free(zio->pool);
 	zio_cleanup(zio);
 	return -1;
 }
 
-static void zio_usage(char *cmd)
+static int zio_run(struct zio_params *zio)
 {
-	printf("Usage: %s [options] <file path>\n",
-	       cmd);
-	printf("Options:\n"
-	       "    -h | --help     : print usage and exit\n"
-	       "    --v             : Verbose output (stats)\n"
-	       "    --vv            : Very verbose output (IOs)\n"
-	       "    --read          : do read (default)\n"
-	       "    --write         : do write\n"
-	       "    --iovec         : Use disjoint vectored buffer\n"
-	       "    --size=<bytes>  : Do <bytes> sized IOs (default: 4096)\n"
-	       "    --ofst=<bytes>  : Start IOs at <offset> (default: 0)\n"
-	       "    --nio=<num>     : Do <num> IOs and exit\n"
-	       "                       (default: IOs until EOF)\n"
-	       "    --async=<depth> : Do asynchronous IOs, issuing at most\n"
-	       "                       <depth> IOs at a time\n"
-	       "    --fflag=<flag>  : Use O_<flag> to open file.\n"
-	       "                      <flag> can be:\n"
-	       "                        - direct\n"
-	       "                        - append\n"
-	       "                        - ndelay\n"
-	       "                        - sync\n"
-	       "                        - dsync\n"
-	       "                        - trunc\n"
-	       "                      This option can be used multiple times.\n"
-	       "    --ioflag=<flag> : Use RWF_<flag> for IOs. <flag> can be:\n"
-	       "                        - nowait\n"
-	       "                        - hipri\n"
-	       "                        - append\n"
-	       "                        - dsync\n"
-	       "                      This option can be used multiple times.\n");
+	zio->rate_start = zio_nsec();
+
+	switch (zio->engine) {
+	case ZIO_ENGINE_AIO:
+		return zio_run_async(zio);
+	case ZIO_ENGINE_URING:
+		return zio_run_uring(zio);
+	case ZIO_ENGINE_MMAP:
+		return zio_run_mmap(zio);
+	case ZIO_ENGINE_SYNC:
+	default:
+		return zio_run_sync(zio);
+	}
 }
 
-int main(int argc, char **argv)
+/*
+ * Do IOs on a file using a copy of the run parameters template.
+ */
+static int zio_run_file(struct zio_job *job, char *path)
 {
-	struct zio_params zio;
-	unsigned long long start;
-	long long arg;
-	int ret, i;
+	struct zio_params *zio = &job->zio;
+	int ret;
 
-	/* Set default values */
-	memset(&zio, 0, sizeof(struct zio_params));
-	zio.fd = -1;
-	zio.read = true;
-	zio.iovec = false;
-	zio.async = false;
-	zio.append = false;
-	zio.fflags = O_LARGEFILE;
-	zio.iosize = 4096;
-	zio.iodepth = 1;
-	zio.verbose = false;
+	*zio = *job->jobs->zio;
+	zio->job = job->id;
+	zio->live = &job->live;
+	zio->zeta = &job->zeta;
+	if (zio->mem != ZIO_MEM_MALLOC)
+		zio->pool = &job->pool;
 
-	if (argc <= 1) {
-		zio_usage(argv[0]);
-		return 1;
+	ret = zio_init(zio, path);
+	if (ret)
+		return -1;
+
+	ret = zio_run(zio);
+	if (ret)
+		fprintf(stderr, "IOs on %s failed\n", path);
+
+	zio_cleanup(zio);
+
+	return ret;
+}
+
+static bool zio_jobs_done(struct zio_jobs *jobs)
+{
+	unsigned long long deadline = jobs->zio->deadline;
+
+	return __atomic_load_n(&jobs->abort, __ATOMIC_RELAXED) ||
+		(deadline && zio_nsec() >= deadline);
+}
+
+/*
+ * Get the index of the next file of a job, or -1 when the job is done.
+ * Files are normally taken in order by the first job available. With
+ * --wrap, job j cycles over the files j, j + nr_jobs, ... until the run
+ * time expires, stopping if a whole cycle did no IO.
+ */
+static int zio_job_next_file(struct zio_job *job, int f,
+			     unsigned long long *cycle_ios)
+{
+	struct zio_jobs *jobs = job->jobs;
+
+	if (zio_jobs_done(jobs))
+		return -1;
+
+	if (jobs->shared) {
+		if (job->stats.nr_files && !jobs->zio->wrap)
+			return -1;
+		f = 0;
+	} else if (!jobs->zio->wrap) {
+		f = __atomic_fetch_add(&jobs->next_file, 1, __ATOMIC_RELAXED);
+		if (f >= (int)jobs->nr_files)
+			return -1;
+		return f;
+	} else if (f < 0) {
+		f = job->id;
+	} else {
+		f += jobs->nr_jobs;
+		if (f >= (int)jobs->nr_files)
+			f = job->id;
 	}
 
-	/* Parse command line */
-	for (i = 1; i < argc; i++) {
+	if (f != (int)job->id && !jobs->shared)
+		return f;
 
-		if (strcmp(argv[i], "-h") == 0 ||
-		    strcmp(argv[i], "--help") == 0) {
-			zio_usage(argv[0]);
-			return 0;
+	/* Start of a new cycle */
+	if (job->stats.nr_files && job->stats.nr_ios == *cycle_ios)
+		return -1;
+	*cycle_ios = job->stats.nr_ios;
+
+	return f;
+}
+
+/*
+ * Job worker: do IOs on files until all files are done or a job fails.
+ * With a shared file, all jobs do IOs to the single file of the list.
+ */
+static void *zio_job_worker(void *arg)
+{
+	struct zio_job *job = arg;
+	struct zio_jobs *jobs = job->jobs;
+	unsigned long long start = zio_usec();
+	unsigned long long cycle_ios = 0;
+	int f = -1;
+
+	if (zio_job_place(job)) {
+		job->ret = -1;
+		__atomic_store_n(&jobs->abort, true, __ATOMIC_RELAXED);
+	}
+
+	while (!job->ret &&
+	       (f = zio_job_next_file(job, f, &cycle_ios)) >= 0) {
+		job->ret = zio_run_file(job, jobs->files[f]);
+		zio_stats_add(&job->stats, &job->zio);
+		if (job->ret) {
+			__atomic_store_n(&jobs->abort, true, __ATOMIC_RELAXED);
+			break;
 		}
+	}
 
-		if (strcmp(argv[i], "--v") == 0) {
-			zio.verbose = true;
-		} else if (strcmp(argv[i], "--read") == 0) {
-			zio.read = true;
-			zio.fflags |= O_RDONLY;
-		} else if (strcmp(argv[i], "--write") == 0) {
-			zio.read = false;
-			zio.fflags |= O_WRONLY;
-		} else if (strcmp(argv[i], "--iovec") == 0) {
-			zio.iovec = true;
-		} else if (strncmp(argv[i], "--size=", 7) == 0) {
-			arg = atol(argv[i] + 7);
-			if (arg <= 0) {
-				fprintf(stderr, "Invalid IO size\n");
-				return 1;
-			}
-			zio.iosize = arg;
-		} else if (strncmp(argv[i], "--ofst=", 7) == 0) {
-			arg = atoll(argv[i] + 7);
-			if (arg < 0) {
-				fprintf(stderr, "Invalid IO offset\n");
-				return 1;
-			}
-			zio.ioofst = arg;
-		} else if (strncmp(argv[i], "--nio=", 6) == 0) {
-			arg = atoi(argv[i] + 6);
-			if (arg <= 0) {
-				fprintf(stderr, "Invalid number of IOs\n");
-				return 1;
-			}
-			zio.ionum = arg;
-		} else if (strncmp(argv[i], "--async=", 8) == 0) {
-			zio.async = true;
-			arg = atoi(argv[i] + 8);
-			if (arg <= 0) {
-				fprintf(stderr, "Invalid async IO depth\n");
-				return 1;
-			}
-			zio.iodepth = arg;
-		} else if (strncmp(argv[i], "--fflag=", 8) == 0) {
-			if (strcmp(argv[i] + 8, "direct") == 0) {
-				zio.fflags |= O_DIRECT;
-			} else if (strcmp(argv[i] + 8, "append") == 0) {
-				zio.fflags |= O_APPEND;
-			} else if (strcmp(argv[i] + 8, "ndelay") == 0) {
-				zio.fflags |= O_NDELAY;
-			} else if (strcmp(argv[i] + 8, "sync") == 0) {
-				zio.fflags |= O_SYNC;
-			} else if (strcmp(argv[i] + 8, "dsync") == 0) {
-				zio.fflags |= O_DSYNC;
+	job->elapsed = zio_usec() - start;
+	job->place.cpu = sched_getcpu();
+	zio_pool_free(&job->pool);
+
+	pthread_mutex_lock(&jobs->lock);
+	jobs->nr_running--;
+	if (!jobs->nr_running)
+		pthread_cond_signal(&jobs->cond);
+	pthread_mutex_unlock(&jobs->lock);
+
+	return NULL;
+}
+
+static void zio_cond_init(pthread_cond_t *cond)
+{
+	pthread_condattr_t attr;
+
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(cond, &attr);
+	pthread_condattr_destroy(&attr);
+}
+
+static volatile sig_atomic_t zio_interim;
+
+static void zio_sigusr1(int sig)
+{
+	zio_interim = 1;
+}
+
+static void zio_print_ns(unsigned long long ns)
+{
+	printf("%llu.%03llu us", ns / 1000, ns % 1000);
+}
+
+/*
+ * Collect the cumulative statistics of all jobs.
+ */
+static void zio_collect(struct zio_jobs *jobs, struct zio_stats *st)
+{
+	unsigned int i;
+
+	zio_stats_init(st);
+	for (i = 0; i < jobs->nr_jobs; i++)
+		zio_live_read(&jobs->job[i].live, st);
+}
+
+/*
+ * Get the statistics of the interval since the collection prev and make
+ * the collection cur the start of the next interval.
+ */
+static void zio_interval(struct zio_stats *ival, struct zio_stats *cur,
+			 struct zio_stats *prev)
+{
+	*ival = *cur;
+	ival->nr_ios -= prev->nr_ios;
+	ival->nr_bytes -= prev->nr_bytes;
+	zio_hist_sub(&ival->lat, &prev->lat);
+	*prev = *cur;
+}
+
+/*
+ * Record the statistics of the interval ending at now, printing them with
+ * the normal output format.
+ */
+static int zio_report_interval(struct zio_jobs *jobs, struct zio_stats *ival,
+			       unsigned long long start,
+			       unsigned long long ival_start,
+			       unsigned long long now)
+{
+	struct zio_sample *sample;
+	unsigned long long iops, bw, t;
+
+	sample = realloc(jobs->samples,
+			 (jobs->nr_samples + 1) * sizeof(struct zio_sample));
+	if (!sample) {
+		fprintf(stderr, "No memory for interval statistics\n");
+		return -1;
+	}
+	jobs->samples = sample;
+	sample += jobs->nr_samples++;
+
+	sample->time = now - start;
+	sample->duration = now - ival_start;
+	sample->nr_ios = ival->nr_ios;
+	sample->nr_bytes = ival->nr_bytes;
+	sample->p50 = zio_hist_pct(&ival->lat, 50);
+	sample->p99 = zio_hist_pct(&ival->lat, 99);
+	sample->max = ival->lat.nr ? ival->lat.max : 0;
+
+	if (jobs->output != ZIO_OUTPUT_NORMAL)
+		return 0;
+
+	t = sample->time / 1000000;
+	iops = 0;
+	bw = 0;
+	if (sample->duration) {
+		iops = sample->nr_ios * 1000000000ULL / sample->duration;
+		bw = sample->nr_bytes * 1000000ULL / sample->duration;
+	}
+	printf("[%5llu.%03llu s] %llu IOPS, %llu.%03llu MB/s",
+	       t / 1000, t % 1000, iops, bw / 1000, bw % 1000);
+	if (sample->nr_ios) {
+		printf(", p50 ");
+		zio_print_ns(sample->p50);
+		printf(", p99 ");
+		zio_print_ns(sample->p99);
+		printf(", max ");
+		zio_print_ns(sample->max);
+	}
+	printf("\n");
+	fflush(stdout);
+
+	return 0;
+}
+
+/*
+ * On SIGUSR1, print the cumulative statistics of the run so far, with the
+ * latency only if interval reports are enabled. With a structured output
+ * format, these are printed to stderr.
+ */
+static void zio_report_interim(struct zio_jobs *jobs, struct zio_stats *st,
+			       unsigned long long start, unsigned long long now)
+{
+	FILE *f = jobs->output == ZIO_OUTPUT_NORMAL ? stdout : stderr;
+	unsigned long long elapsed = (now - start) / 1000;
+	unsigned long long iops, bw;
+
+	if (!elapsed)
+		elapsed = 1;
+	iops = st->nr_ios * 1000000ULL / elapsed;
+	bw = st->nr_bytes * 1000000ULL / elapsed;
+
+	fprintf(f, "Interim stats at %llu ms: %llu IOs\n",
+		elapsed / 1000, st->nr_ios);
+	fprintf(f, "    %llu IOPS, %llu.%03llu MB/s\n",
+		iops, bw / 1000000, (bw % 1000000) / 1000);
+	zio_hist_print(f, &st->lat, "    ");
+	fflush(f);
+}
+
+/*
+ * Wait for all jobs to complete, reporting statistics every interval and
+ * on SIGUSR1.
+ */
+static int zio_report(struct zio_jobs *jobs)
+{
+	unsigned long long start = zio_nsec(), ival_start = start;
+	unsigned long long now, wake;
+	struct zio_stats cur, prev, ival;
+	struct timespec ts;
+	int ret = 0;
+
+	zio_stats_init(&prev);
+
+	pthread_mutex_lock(&jobs->lock);
+	while (jobs->nr_running) {
+		/* Check for SIGUSR1 at least every 100 ms */
+		wake = zio_nsec() + 100000000ULL;
+		if (jobs->interval_ns && ival_start + jobs->interval_ns < wake)
+			wake = ival_start + jobs->interval_ns;
+		ts.tv_sec = wake / 1000000000ULL;
+		ts.tv_nsec = wake % 1000000000ULL;
+		pthread_cond_timedwait(&jobs->cond, &jobs->lock, &ts);
+		pthread_mutex_unlock(&jobs->lock);
+
+		now = zio_nsec();
+		if (jobs->interval_ns && now >= ival_start + jobs->interval_ns) {
+			zio_collect(jobs, &cur);
+			zio_interval(&ival, &cur, &prev);
+			if (zio_report_interval(jobs, &ival, start, ival_start,
+						now))
+				ret = -1;
+			ival_start = now;
+		}
+
+		if (zio_interim) {
+			zio_interim = 0;
+			zio_collect(jobs, &cur);
+			zio_report_interim(jobs, &cur, start, now);
+		}
+
+		pthread_mutex_lock(&jobs->lock);
+	}
+	pthread_mutex_unlock(&jobs->lock);
+
+	/* Last partial interval */
+	if (jobs->interval_ns) {
+		zio_collect(jobs, &cur);
+		zio_interval(&ival, &cur, &prev);
+		if (ival.nr_ios &&
+		    zio_report_interval(jobs, &ival, start, ival_start,
+					zio_nsec()))
+			ret = -1;
+	}
+
+	return ret;
+}
+
+/*
+ * Run all jobs and wait for them to complete. IOs are done by worker
+ * threads, with SIGUSR1 blocked so that the main thread handles it.
+ */
+static int zio_run_jobs(struct zio_jobs *jobs)
+{
+	struct sigaction sa;
+	sigset_t mask, omask;
+	struct zio_job *job;
+	unsigned int i, nr_started;
+	int ret = 0;
+
+	/* Start from scratch when running the jobs again */
+	free(jobs->job);
+	jobs->next_file = 0;
+	jobs->nr_samples = 0;
+	jobs->abort = false;
+
+	jobs->job = calloc(jobs->nr_jobs, sizeof(struct zio_job));
+	if (!jobs->job) {
+		fprintf(stderr, "No memory for jobs\n");
+		return -1;
+	}
+
+	pthread_mutex_init(&jobs->lock, NULL);
+	zio_cond_init(&jobs->cond);
+
+	for (i = 0; i < jobs->nr_jobs; i++) {
+		job = &jobs->job[i];
+		job->id = i;
+		job->jobs = jobs;
+		zio_stats_init(&job->stats);
+		zio_live_init(&job->live, jobs->interval_ns != 0);
+	}
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = zio_sigusr1;
+	sa.sa_flags = SA_RESTART;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGUSR1, &sa, NULL);
+
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGUSR1);
+	pthread_sigmask(SIG_BLOCK, &mask, &omask);
+
+	jobs->nr_running = jobs->nr_jobs;
+	for (nr_started = 0; nr_started < jobs->nr_jobs; nr_started++) {
+		job = &jobs->job[nr_started];
+		ret = pthread_create(&job->thread, NULL, zio_job_worker, job);
+		if (ret) {
+			fprintf(stderr, "Create job %u failed %d (%s)\n",
+				nr_started, ret, strerror(ret));
+			__atomic_store_n(&jobs->abort, true, __ATOMIC_RELAXED);
+			pthread_mutex_lock(&jobs->lock);
+			jobs->nr_running -= jobs->nr_jobs - nr_started;
+			pthread_mutex_unlock(&jobs->lock);
+			ret = -1;
+			break;
+		}
+	}
+
+	pthread_sigmask(SIG_SETMASK, &omask, NULL);
+
+	if (zio_report(jobs))
+		ret = -1;
+
+	for (i = 0; i < nr_started; i++) {
+		job = &jobs->job[i];
+		pthread_join(job->thread, NULL);
+		if (job->ret)
+			ret = -1;
+	}
+
+	pthread_cond_destroy(&jobs->cond);
+	pthread_mutex_destroy(&jobs->lock);
+
+	return ret;
+}
+
+/*
+ * Build the file list from the path arguments. With a file range, each path
+ * argument is a directory and files <first> to <last> of the directory are
+ * used.
+ */
+static int zio_get_files(struct zio_jobs *jobs, char **paths,
+			 unsigned int nr_paths, bool range,
+			 unsigned int first, unsigned int last)
+{
+	unsigned int i, n, nr_files = nr_paths;
+
+	if (range)
+		nr_files *= last - first + 1;
+
+	jobs->files = calloc(nr_files, sizeof(char *));
+	if (!jobs->files) {
+		fprintf(stderr, "No memory for file list\n");
+		return -1;
+	}
+
+	for (i = 0; i < nr_paths; i++) {
+		if (!range) {
+			jobs->files[jobs->nr_files] = strdup(paths[i]);
+			if (!jobs->files[jobs->nr_files])
+				goto nomem;
+			jobs->nr_files++;
+			continue;
+		}
+
+		for (n = first; n <= last; n++) {
+			if (asprintf(&jobs->files[jobs->nr_files], "%s/%u",
+				     paths[i], n) < 0)
+				goto nomem;
+			jobs->nr_files++;
+		}
+	}
+
+	return 0;
+
+nomem:
+	fprintf(stderr, "No memory for file list\n");
+	return -1;
+}
+
+/*
+ * Prepare jobs sharing a file. Without a number of IOs specified, the
+ * space left in the file is split evenly between the jobs for append
+ * writes.
+ */
+static int zio_prep_shared(struct zio_jobs *jobs)
+{
+	struct zio_params *zio = jobs->zio;
+	unsigned long long nr_ios;
+	struct stat st;
+
+	if (jobs->nr_files != 1) {
+		fprintf(stderr, "--shared-file requires a single file\n");
+		return -1;
+	}
+
+	if (!zio->read) {
+		if (!(zio->fflags & O_APPEND) &&
+		    !(zio->ioflags & RWF_APPEND)) {
+			fprintf(stderr,
+				"--shared-file writes require append writes\n");
+			return -1;
+		}
+		if (zio->fflags & O_TRUNC) {
+			fprintf(stderr,
+				"--shared-file cannot be used with trunc\n");
+			return -1;
+		}
+	}
+
+	if (stat(jobs->files[0], &st)) {
+		fprintf(stderr, "Stat %s failed %d (%s)\n",
+			jobs->files[0], errno, strerror(errno));
+		return -1;
+	}
+	jobs->shared_fsize = st.st_size;
+
+	if (zio->read || zio->ionum)
+		return 0;
+
+	nr_ios = 0;
+	if ((st.st_blocks << 9) > st.st_size)
+		nr_ios = ((st.st_blocks << 9) - st.st_size) / zio->iosize;
+	nr_ios /= jobs->nr_jobs;
+	if (!nr_ios) {
+		fprintf(stderr, "No space left in %s for %u jobs\n",
+			jobs->files[0], jobs->nr_jobs);
+		return -1;
+	}
+	zio->ionum = nr_ios;
+
+	return 0;
+}
+
+/*
+ * With append writes to a shared file, check that the file size grew by
+ * exactly the amount of data written by all jobs.
+ */
+static int zio_check_shared(struct zio_jobs *jobs, struct zio_stats *st)
+{
+	loff_t expected = jobs->shared_fsize + st->nr_bytes;
+	struct stat stf;
+
+	if (stat(jobs->files[0], &stf)) {
+		fprintf(stderr, "Stat %s failed %d (%s)\n",
+			jobs->files[0], errno, strerror(errno));
+		return -1;
+	}
+
+	if (jobs->output == ZIO_OUTPUT_NORMAL)
+		printf("    File size: %lld B (expected %lld B)\n",
+		       (long long)stf.st_size, (long long)expected);
+	if (stf.st_size != expected) {
+		fprintf(stderr, "%s: invalid file size %lld B, expected %lld B\n",
+			jobs->files[0], (long long)stf.st_size,
+			(long long)expected);
+		return -1;
+	}
+
+	return 0;
+}
+
+static void zio_put_files(struct zio_jobs *jobs)
+{
+	unsigned int i;
+
+	for (i = 0; i < jobs->nr_files; i++)
+		free(jobs->files[i]);
+	free(jobs->files);
+	free(jobs->job);
+	free(jobs->samples);
+	free(jobs->cpus);
+}
+
+const char *zio_poll_name(enum zio_poll poll)
+{
+	switch (poll) {
+	case ZIO_POLL_BUSY:
+		return "busy poll";
+	case ZIO_POLL_HYBRID:
+		return "hybrid poll";
+	case ZIO_POLL_NONE:
+	default:
+		return "interrupts";
+	}
+}
+
+const char *zio_engine_name(enum zio_engine engine)
+{
+	switch (engine) {
+	case ZIO_ENGINE_SYNC:
+		return "sync";
+	case ZIO_ENGINE_AIO:
+		return "aio";
+	case ZIO_ENGINE_URING:
+		return "uring";
+	case ZIO_ENGINE_MMAP:
+		return "mmap";
+	default:
+		return "unknown";
+	}
+}
+
+/*
+ * Print the CPU time and the number of IO system calls used by the run, in
+ * total and per IO.
+ */
+static void zio_print_cpu(struct zio_params *zio, struct zio_result *res)
+{
+	struct zio_stats *st = &res->st;
+	unsigned long long usr = res->cpu_usr, sys = res->cpu_sys;
+
+	printf("    %s engine", zio_engine_name(zio->engine));
+	if (zio->engine == ZIO_ENGINE_URING)
+		printf(" (%s)", zio_poll_name(zio->poll));
+	if (zio->engine == ZIO_ENGINE_MMAP) {
+		printf(" (%s", zio->mmap_copy ? "copy" : "checksum");
+		if (zio->madv) {
+			printf(", madvise ");
+			zio_print_madv(stdout, zio->madv, "+");
+		}
+		printf(")");
+	}
+	printf(", %s buffers%s", zio_mem_name(zio->mem),
+	       zio->fixed_bufs ? " (fixed)" : "");
+	printf(", CPU: %llu us user, %llu us system", usr, sys);
+	if (st->nr_ios)
+		printf(", %llu.%03llu us/IO",
+		       (usr + sys) / st->nr_ios,
+		       ((usr + sys) * 1000 / st->nr_ios) % 1000);
+	printf("\n");
+
+	printf("    %llu system calls", st->nr_syscalls);
+	if (st->nr_ios)
+		printf(", %llu.%03llu per IO",
+		       st->nr_syscalls / st->nr_ios,
+		       (st->nr_syscalls * 1000 / st->nr_ios) % 1000);
+	printf("\n");
+
+	if (zio->engine != ZIO_ENGINE_MMAP)
+		return;
+
+	printf("    %llu major, %llu minor page faults",
+	       res->majflt, res->minflt);
+	if (st->nr_ios)
+		printf(", %llu.%03llu per IO",
+		       (res->majflt + res->minflt) / st->nr_ios,
+		       ((res->majflt + res->minflt) * 1000 / st->nr_ios) %
+		       1000);
+	printf("\n");
+	if (!zio->mmap_copy)
+		printf("    Checksum: 0x%016llx\n", st->mmap_sum);
+}
+
+static void zio_print_rand(struct zio_params *zio)
+{
+	switch (zio->rand) {
+	case ZIO_RAND_ZIPF:
+		printf("    Random offsets: zipf, theta %.2f",
+		       zio->zipf_theta);
+		break;
+	case ZIO_RAND_HOTSPOT:
+		printf("    Random offsets: hot spot, %u %% of IOs to %u %% of data",
+		       zio->hot_access_pct, zio->hot_pct);
+		break;
+	case ZIO_RAND_UNIFORM:
+	default:
+		printf("    Random offsets: uniform");
+		break;
+	}
+
+	if (zio->rand_align)
+		printf(", %zu B aligned", zio->rand_align);
+	if (zio->rand_wset)
+		printf(", %lld B working set", (long long)zio->rand_wset);
+	printf("\n");
+}
+
+/*
+ * Print the data synchronization method used for writes, so that the
+ * latency of runs with and without O_DSYNC or RWF_DSYNC can be compared.
+ */
+static void zio_print_write_sync(struct zio_params *zio)
+{
+	printf("    Write sync:");
+	if ((zio->fflags & O_SYNC) == O_SYNC)
+		printf(" O_SYNC");
+	else if (zio->fflags & O_DSYNC)
+		printf(" O_DSYNC");
+	if (zio->ioflags & RWF_DSYNC)
+		printf(" RWF_DSYNC");
+	if (!(zio->fflags & O_DSYNC) && !(zio->ioflags & RWF_DSYNC))
+		printf(" none");
+	printf("\n");
+}
+
+/*
+ * Print how far the achieved rate and the IO issue times fell behind the
+ * target rate schedule.
+ */
+static void zio_print_rate(struct zio_stats *st, double rate_iops,
+			   unsigned long long iops)
+{
+	unsigned long long pct, lag_mean = 0;
+
+	pct = iops * 1000ULL / rate_iops;
+	if (st->nr_ios)
+		lag_mean = st->rate_lag_sum / st->nr_ios;
+
+	printf("    Rate: target %.0f IOPS, achieved %llu IOPS (%llu.%llu %%)\n",
+	       rate_iops, iops, pct / 10, pct % 10);
+	printf("    Issue lag: mean %llu.%03llu us, max %llu.%03llu us\n",
+	       lag_mean / 1000, lag_mean % 1000,
+	       st->rate_lag_max / 1000, st->rate_lag_max % 1000);
+}
+
+/*
+ * Print the IOs done by each job.
+ */
+static void zio_print_jobs(struct zio_jobs *jobs)
+{
+	unsigned long long bw, p50, p99;
+	struct zio_job *job;
+	unsigned int i;
+
+	for (i = 0; i < jobs->nr_jobs; i++) {
+		job = &jobs->job[i];
+		bw = 0;
+		if (job->elapsed)
+			bw = job->stats.nr_bytes * 1000000ULL / job->elapsed;
+		printf("    Job %u: %u file%s, %llu IOs, %llu.%03llu MB/s",
+		       job->id, job->stats.nr_files,
+		       job->stats.nr_files > 1 ? "s" : "",
+		       job->stats.nr_ios,
+		       bw / 1000000, (bw % 1000000) / 1000);
+		if (job->stats.lat.nr) {
+			p50 = zio_hist_pct(&job->stats.lat, 50);
+			p99 = zio_hist_pct(&job->stats.lat, 99);
+			printf(", p50 %llu.%03llu us, p99 %llu.%03llu us",
+			       p50 / 1000, p50 % 1000, p99 / 1000, p99 % 1000);
+		}
+		printf("\n");
+	}
+}
+
+/*
+ * Parse CPU lists separated with ':', used in turn by jobs.
+ */
+static int zio_parse_cpus(struct zio_jobs *jobs, const char *arg)
+{
+	char *str, *list, *saveptr = NULL;
+	cpu_set_t *cpus;
+	int ret = -1;
+
+	str = strdup(arg);
+	if (!str)
+		return -1;
+
+	for (list = strtok_r(str, ":", &saveptr); list;
+	     list = strtok_r(NULL, ":", &saveptr)) {
+		cpus = realloc(jobs->cpus,
+			       (jobs->nr_cpus + 1) * sizeof(cpu_set_t));
+		if (!cpus)
+			goto out;
+		jobs->cpus = cpus;
+		if (zio_parse_cpulist(list, &jobs->cpus[jobs->nr_cpus]))
+			goto out;
+		jobs->nr_cpus++;
+	}
+
+	if (jobs->nr_cpus)
+		ret = 0;
+out:
+	free(str);
+
+	return ret;
+}
+
+/*
+ * Gather the results of all jobs.
+ */
+static void zio_get_result(struct zio_jobs *jobs, struct zio_result *res,
+			   unsigned long long elapsed, struct rusage *ru_start)
+{
+	struct rusage ru;
+	unsigned int i;
+
+	zio_stats_init(&res->st);
+	for (i = 0; i < jobs->nr_jobs; i++)
+		zio_stats_merge(&res->st, &jobs->job[i].stats);
+
+	if (!elapsed)
+		elapsed = 1;
+	res->elapsed = elapsed;
+	res->iops = res->st.nr_ios * 1000000ULL / elapsed;
+	res->bw = res->st.nr_bytes * 1000000.0 / elapsed;
+
+	getrusage(RUSAGE_SELF, &ru);
+	res->cpu_usr =
+		(ru.ru_utime.tv_sec - ru_start->ru_utime.tv_sec) * 1000000ULL +
+		ru.ru_utime.tv_usec - ru_start->ru_utime.tv_usec;
+	res->cpu_sys =
+		(ru.ru_stime.tv_sec - ru_start->ru_stime.tv_sec) * 1000000ULL +
+		ru.ru_stime.tv_usec - ru_start->ru_stime.tv_usec;
+	res->minflt = ru.ru_minflt - ru_start->ru_minflt;
+	res->majflt = ru.ru_majflt - ru_start->ru_majflt;
+}
+
+/*
+ * Print the results of a run in human readable form.
+ */
+static void zio_print_result(struct zio_jobs *jobs, struct zio_result *res)
+{
+	struct zio_params *zio = jobs->zio;
+	struct zio_stats *st = &res->st;
+
+	printf("%llu IOs done in %llu ms (%llu us)\n",
+	       st->nr_ios, res->elapsed / 1000, res->elapsed);
+	if (jobs->shared)
+		printf("    %u job%s, shared file\n",
+		       jobs->nr_jobs, jobs->nr_jobs > 1 ? "s" : "");
+	else if (jobs->nr_files > 1)
+		printf("    %u job%s, %u files\n",
+		       jobs->nr_jobs, jobs->nr_jobs > 1 ? "s" : "",
+		       jobs->nr_files);
+	printf("    %llu IOPS, %llu.%03llu MB/s\n",
+	       res->iops, res->bw / 1000000, (res->bw % 1000000) / 1000);
+	if (zio->rand)
+		zio_print_rand(zio);
+	if (!zio->read)
+		zio_print_write_sync(zio);
+	zio_print_cpu(zio, res);
+	if (zio->read && (zio->evict || zio->cache_stats))
+		zio_print_cache(zio, st);
+	zio_print_placement(jobs);
+	zio_hist_print(stdout, &st->lat, "    ");
+	if (res->rate_iops)
+		zio_print_rate(st, res->rate_iops, res->iops);
+	if (zio->verify && zio->read)
+		printf("    Verified %llu blocks, %llu error%s\n",
+		       st->nr_verified, st->nr_verify_errors,
+		       st->nr_verify_errors != 1 ? "s" : "");
+	if (jobs->nr_jobs > 1)
+		zio_print_jobs(jobs);
+}
+
+/*
+ * Run all jobs once and gather their results.
+ */
+static int zio_run_pass(struct zio_jobs *jobs, struct zio_result *res,
+			double rate_iops, double runtime)
+{
+	struct rusage ru_start;
+	unsigned long long start;
+
+	getrusage(RUSAGE_SELF, &ru_start);
+	start = zio_usec();
+	if (runtime)
+		jobs->zio->deadline = zio_nsec() + runtime * 1000000000.0;
+
+	if (zio_run_jobs(jobs))
+		return -1;
+
+	res->rate_iops = rate_iops;
+	res->runtime = runtime;
+	zio_get_result(jobs, res, zio_usec() - start, &ru_start);
+
+	return 0;
+}
+
+static void zio_print_pass(const char *name, struct zio_result *res)
+{
+	unsigned long long pct = zio_cache_hit_pct(&res->st);
+
+	printf("%s %llu.%03llu MB/s (%llu.%02llu %% hits)", name,
+	       res->bw / 1000000, (res->bw % 1000000) / 1000,
+	       pct / 100, pct % 100);
+}
+
+/*
+ * Print the cold and warm pass throughput and page cache hit ratio of each
+ * readahead window of a sweep.
+ */
+static void zio_print_sweep(struct zio_jobs *jobs, struct zio_ra_pass *pass,
+			    unsigned int nr_passes)
+{
+	struct zio_params *zio = jobs->zio;
+	unsigned int i;
+
+	printf("Readahead window sweep: %s hints, %zu B reads, %u file%s\n",
+	       zio_ra_hint_name(zio->ra_hint), zio->iosize,
+	       jobs->nr_files, jobs->nr_files > 1 ? "s" : "");
+
+	for (i = 0; i + 1 < nr_passes; i += 2) {
+		printf("    %zu B window: ", pass[i].window);
+		zio_print_pass("cold", &pass[i].res);
+		printf(", ");
+		zio_print_pass("warm", &pass[i + 1].res);
+		printf("\n");
+	}
+}
+
+/*
+ * Readahead window sweep: for each window from ra_min to ra_max, doubling
+ * the window, read the files after evicting them from the page cache (cold
+ * pass), then read them again (warm pass).
+ */
+static int zio_ra_sweep(struct zio_jobs *jobs, double rate_iops)
+{
+	struct zio_params *zio = jobs->zio;
+	struct zio_ra_pass *pass = NULL, *p;
+	unsigned int i, nr_passes = 0;
+	size_t window;
+	int ret = 0;
+
+	for (window = jobs->ra_min; window <= jobs->ra_max; window *= 2) {
+		p = realloc(pass, (nr_passes + 2) * sizeof(struct zio_ra_pass));
+		if (!p) {
+			fprintf(stderr, "No memory for sweep results\n");
+			ret = -1;
+			goto out;
+		}
+		pass = p;
+
+		for (i = 0; i < 2; i++) {
+			p = &pass[nr_passes];
+			p->window = window;
+			p->cold = i == 0;
+			zio->ra_window = window;
+			zio->evict = p->cold;
+			if (zio_run_pass(jobs, &p->res, rate_iops, 0)) {
+				ret = -1;
+				goto out;
+			}
+			if (zio->verify && p->res.st.nr_verify_errors)
+				ret = -1;
+			nr_passes++;
+		}
+	}
+
+	switch (jobs->output) {
+	case ZIO_OUTPUT_JSON:
+		zio_output_sweep_json(jobs, pass, nr_passes);
+		break;
+	case ZIO_OUTPUT_CSV:
+		zio_output_sweep_csv(jobs, pass, nr_passes);
+		break;
+	case ZIO_OUTPUT_NORMAL:
+	default:
+		zio_print_sweep(jobs, pass, nr_passes);
+		break;
+	}
+
+out:
+	free(pass);
+
+	return ret;
+}
+
+static void zio_usage(char *cmd)
+{
+	printf("Usage: %s [options] <file path> [<file path> ...]\n",
+	       cmd);
+	printf("Options:\n"
+	       "    -h | --help     : print usage and exit\n"
+	       "    --v             : Verbose output (stats)\n"
+	       "    --vv            : Very verbose output (IOs)\n"
+	       "    --read          : do read (default)\n"
+	       "    --write         : do write\n"
+	       "    --iovec         : Use disjoint vectored buffer\n"
+	       "    --size=<bytes>  : Do <bytes> sized IOs (default: 4096)\n"
+	       "    --ofst=<bytes>  : Start IOs at <offset> (default: 0)\n"
+	       "    --nio=<num>     : Do <num> IOs and exit\n"
+	       "                       (default: IOs until EOF)\n"
+	       "    --async=<depth> : Do asynchronous IOs, issuing at most\n"
+	       "                       <depth> IOs at a time\n"
+	       "    --batch-min=<n> : Wait for at least <n> async IOs to\n"
+	       "                      complete before reissuing IOs\n"
+	       "                      (default: 1)\n"
+	       "    --batch-max=<n> : Reap at most <n> async IO completions\n"
+	       "                      at a time (default: IO depth)\n"
+	       "    --engine=<name> : Use the <name> IO engine. <name> can be:\n"
+	       "                        - sync (default without --async)\n"
+	       "                        - aio (default with --async)\n"
+	       "                        - uring\n"
+	       "                        - mmap: read the file mapping\n"
+	       "                          (reads only, no --iovec)\n"
+	       "    --mmap-read=<mode> : With the mmap engine, for each IO:\n"
+	       "                        - copy: copy the data to the IO\n"
+	       "                          buffer (default)\n"
+	       "                        - checksum: sum the data in place\n"
+	       "    --madvise=<hint> : With the mmap engine, advise the\n"
+	       "                       kernel of the file mapping use.\n"
+	       "                       <hint> can be:\n"
+	       "                        - sequential\n"
+	       "                        - random\n"
+	       "                        - willneed\n"
+	       "                        - hugepage\n"
+	       "                       This option can be used multiple times.\n"
+	       "    --evict         : With reads, evict the file pages from\n"
+	       "                      the page cache before reading each\n"
+	       "                      file (cold reads)\n"
+	       "    --ra-hint=<hint> : With buffered reads and the sync\n"
+	       "                       engine, count the page cache hits of\n"
+	       "                       reads and give readahead hints.\n"
+	       "                       <hint> can be:\n"
+	       "                        - none: kernel readahead only\n"
+	       "                        - sequential: POSIX_FADV_SEQUENTIAL\n"
+	       "                        - random: POSIX_FADV_RANDOM\n"
+	       "                        - willneed: POSIX_FADV_WILLNEED on\n"
+	       "                          the window ahead of reads\n"
+	       "                        - readahead: readahead() on the\n"
+	       "                          window ahead of reads\n"
+	       "    --ra-window=<bytes> : Readahead window of the willneed and\n"
+	       "                          readahead hints (default: 131072)\n"
+	       "    --ra-sweep=<min>-<max> : For each readahead window from\n"
+	       "                       <min> to <max> bytes, doubling the\n"
+	       "                       window, read the files with --evict\n"
+	       "                       (cold) and again without (warm), and\n"
+	       "                       print the throughput and page cache\n"
+	       "                       hit ratio of each pass\n"
+	       "    --sqpoll[=<ms>] : With the uring engine, use a kernel\n"
+	       "                      thread to poll the submission queue,\n"
+	       "                      idling after <ms> milliseconds\n"
+	       "    --poll[=<mode>] : With the uring engine and direct IOs,\n"
+	       "                      poll for IO completions instead of\n"
+	       "                      using interrupts. <mode> can be:\n"
+	       "                        - busy (default)\n"
+	       "                        - hybrid: sleep for about half of\n"
+	       "                          the IO time before polling\n"
+	       "                      --ioflag=hipri with the uring engine\n"
+	       "                      implies --poll\n"
+	       "    --fixed-files   : With the uring engine, register the\n"
+	       "                      file with the ring\n"
+	       "    --fixed-bufs    : With the uring engine, register the\n"
+	       "                      IO buffers with the ring\n"
+	       "    --mem=<type>    : Allocate IO buffers from <type> memory.\n"
+	       "                      <type> can be:\n"
+	       "                        - malloc: one allocation per IO\n"
+	       "                          (default)\n"
+	       "                        - hugetlb: a pool of huge pages\n"
+	       "                          reserved with\n"
+	       "                          /proc/sys/vm/nr_hugepages\n"
+	       "                        - thp: a pool of transparent huge\n"
+	       "                          pages\n"
+	       "    --lat-hist=<file> : Save the IO latency histogram to\n"
+	       "                        <file>\n"
+	       "    --jobs=<n>      : Run <n> threads, each doing IOs to one\n"
+	       "                      file at a time from the file list\n"
+	       "                      (default: 1)\n"
+	       "    --cpus=<list>[:<list>...] : Run jobs on the CPUs of\n"
+	       "                      <list> (e.g. 0-3,8). With several\n"
+	       "                      lists, job <n> uses list <n> modulo\n"
+	       "                      the number of lists\n"
+	       "    --numa-node=<n> : Allocate job memory from NUMA node <n>.\n"
+	       "                      Without --cpus, run jobs on the CPUs\n"
+	       "                      of node <n>\n"
+	       "    --file-range=<first>-<last> : Use the files <first> to\n"
+	       "                      <last> of each <file path> directory\n"
+	       "    --rand=<dist>   : Do random IOs aligned to the file\n"
+	       "                      block size over the file. Without\n"
+	       "                      --nio, do as many IOs as the file\n"
+	       "                      size allows. Random writes can only\n"
+	       "                      be done to conventional files.\n"
+	       "                      <dist> can be:\n"
+	       "                        - uniform\n"
+	       "                        - zipf[:<theta>] (default: 0.99,\n"
+	       "                          0 < theta < 1)\n"
+	       "                        - hotspot[:<hot>:<access>]: <access>\n"
+	       "                          %% of IOs go to the first <hot> %%\n"
+	       "                          of the file (default: 10:90)\n"
+	       "    --rand-seed=<n> : Seed of random offsets (default: 1)\n"
+	       "    --align=<bytes> : Align random IOs to <bytes>\n"
+	       "    --wset=<bytes>  : Limit random IOs to the first <bytes>\n"
+	       "                      of the file\n"
+	       "    --rate-iops=<n> : Issue IOs on a fixed schedule at <n> IOPS\n"
+	       "                      in total for all jobs, measuring\n"
+	       "                      latency from the time IOs are due\n"
+	       "    --rate-bw=<MB/s> : Same as --rate-iops, with the rate\n"
+	       "                       given as a bandwidth\n"
+	       "    --verify[=<seed>] : Stamp written blocks with a header and\n"
+	       "                        a payload generated from <seed>\n"
+	       "                        (default: 1) and check them on read\n"
+	       "    --runtime=<sec> : Stop after <sec> seconds\n"
+	       "    --interval=<sec> : Print the IOPS, bandwidth and latency\n"
+	       "                       of each <sec> seconds interval\n"
+	       "    --wrap          : With --runtime, cycle over the files\n"
+	       "                      until the run time expires. Full files\n"
+	       "                      are truncated before append writes\n"
+	       "                      restart from their beginning\n"
+	       "    --output-format=<fmt> : Print the results as <fmt>:\n"
+	       "                        - normal (default)\n"
+	       "                        - json: run parameters, totals,\n"
+	       "                          per-job results and interval\n"
+	       "                          samples\n"
+	       "                        - csv: a header line, a total row\n"
+	       "                          and one row per interval\n"
+	       "    --shared-file   : All jobs do IOs to the same single\n"
+	       "                      file. Writes must be append writes.\n"
+	       "                      Without --nio, the file free space\n"
+	       "                      is split evenly between jobs\n"
+	       "    --fflag=<flag>  : Use O_<flag> to open file.\n"
+	       "                      <flag> can be:\n"
+	       "                        - direct\n"
+	       "                        - append\n"
+	       "                        - ndelay\n"
+	       "                        - sync\n"
+	       "                        - dsync\n"
+	       "                        - trunc\n"
+	       "                      This option can be used multiple times.\n"
+	       "    --ioflag=<flag> : Use RWF_<flag> for IOs. <flag> can be:\n"
+	       "                        - nowait\n"
+	       "                        - hipri\n"
+	       "                        - append\n"
+	       "                        - dsync\n"
+	       "                      This option can be used multiple times.\n"
+	       "Send SIGUSR1 to print the statistics of the run so far.\n");
+}
+
+int main(int argc, char **argv)
+{
+	struct zio_params zio;
+	struct zio_jobs jobs;
+	struct zio_result res;
+	bool engine_set = false;
+	bool mmap_read = false;
+	bool ra_window = false;
+	bool range = false;
+	double rate_iops = 0, rate_bw = 0, runtime = 0, interval = 0;
+	unsigned int first = 0, last = 0, nr_paths = 0;
+	char **paths;
+	long long arg;
+	int ret, i;
+
+	/* Set default values */
+	memset(&zio, 0, sizeof(struct zio_params));
+	zio.fd = -1;
+	zio.read = true;
+	zio.iovec = false;
+	zio.async = false;
+	zio.engine = ZIO_ENGINE_SYNC;
+	zio.append = false;
+	zio.fflags = O_LARGEFILE;
+	zio.iosize = 4096;
+	zio.iodepth = 1;
+	zio.verbose = false;
+	zio.rand_seed = 1;
+	zio.mmap_copy = true;
+	zio.ra_window = 128 * 1024;
+	zio_hist_init(&zio.lat);
+
+	memset(&jobs, 0, sizeof(struct zio_jobs));
+	jobs.zio = &zio;
+	jobs.nr_jobs = 1;
+	jobs.numa_node = -1;
+
+	if (argc <= 1) {
+		zio_usage(argv[0]);
+		return 1;
+	}
+
+	paths = calloc(argc, sizeof(char *));
+	if (!paths) {
+		fprintf(stderr, "No memory for file paths\n");
+		return 1;
+	}
+
+	/* Parse command line */
+	for (i = 1; i < argc; i++) {
+
+		if (strcmp(argv[i], "-h") == 0 ||
+		    strcmp(argv[i], "--help") == 0) {
+			zio_usage(argv[0]);
+			return 0;
+		}
+
+		if (strcmp(argv[i], "--v") == 0) {
+			zio.verbose = true;
+		} else if (strcmp(argv[i], "--read") == 0) {
+			zio.read = true;
+			zio.fflags |= O_RDONLY;
+		} else if (strcmp(argv[i], "--write") == 0) {
+			zio.read = false;
+			zio.fflags |= O_WRONLY;
+		} else if (strcmp(argv[i], "--iovec") == 0) {
+			zio.iovec = true;
+		} else if (strncmp(argv[i], "--size=", 7) == 0) {
+			arg = atol(argv[i] + 7);
+			if (arg <= 0) {
+				fprintf(stderr, "Invalid IO size\n");
+				return 1;
+			}
+			zio.iosize = arg;
+		} else if (strncmp(argv[i], "--ofst=", 7) == 0) {
+			arg = atoll(argv[i] + 7);
+			if (arg < 0) {
+				fprintf(stderr, "Invalid IO offset\n");
+				return 1;
+			}
+			zio.ioofst = arg;
+		} else if (strncmp(argv[i], "--nio=", 6) == 0) {
+			arg = atoi(argv[i] + 6);
+			if (arg <= 0) {
+				fprintf(stderr, "Invalid number of IOs\n");
+				return 1;
+			}
+			zio.ionum = arg;
+		} else if (strncmp(argv[i], "--async=", 8) == 0) {
+			zio.async = true;
+			arg = atoi(argv[i] + 8);
+			if (arg <= 0) {
+				fprintf(stderr, "Invalid async IO depth\n");
+				return 1;
+			}
+			zio.iodepth = arg;
+		} else if (strncmp(argv[i], "--batch-min=", 12) == 0) {
+			arg = atoi(argv[i] + 12);
+			if (arg <= 0) {
+				fprintf(stderr, "Invalid minimum batch size\n");
+				return 1;
+			}
+			zio.batch_min = arg;
+		} else if (strncmp(argv[i], "--batch-max=", 12) == 0) {
+			arg = atoi(argv[i] + 12);
+			if (arg <= 0) {
+				fprintf(stderr, "Invalid maximum batch size\n");
+				return 1;
+			}
+			zio.batch_max = arg;
+		} else if (strncmp(argv[i], "--engine=", 9) == 0) {
+			if (strcmp(argv[i] + 9, "sync") == 0) {
+				zio.engine = ZIO_ENGINE_SYNC;
+			} else if (strcmp(argv[i] + 9, "aio") == 0) {
+				zio.engine = ZIO_ENGINE_AIO;
+			} else if (strcmp(argv[i] + 9, "uring") == 0) {
+				zio.engine = ZIO_ENGINE_URING;
+			} else if (strcmp(argv[i] + 9, "mmap") == 0) {
+				zio.engine = ZIO_ENGINE_MMAP;
+			} else {
+				fprintf(stderr, "Invalid IO engine\n");
+				return 1;
+			}
+			engine_set = true;
+		} else if (strcmp(argv[i], "--sqpoll") == 0) {
+			zio.sqpoll = true;
+		} else if (strncmp(argv[i], "--sqpoll=", 9) == 0) {
+			arg = atoi(argv[i] + 9);
+			if (arg <= 0) {
+				fprintf(stderr, "Invalid SQ poll idle time\n");
+				return 1;
+			}
+			zio.sqpoll = true;
+			zio.sqpoll_idle = arg;
+		} else if (strcmp(argv[i], "--poll") == 0 ||
+			   strcmp(argv[i], "--poll=busy") == 0) {
+			zio.poll = ZIO_POLL_BUSY;
+		} else if (strcmp(argv[i], "--poll=hybrid") == 0) {
+			zio.poll = ZIO_POLL_HYBRID;
+		} else if (strncmp(argv[i], "--poll=", 7) == 0) {
+			fprintf(stderr, "Invalid poll mode\n");
+			return 1;
+		} else if (strcmp(argv[i], "--fixed-files") == 0) {
+			zio.fixed_files = true;
+		} else if (strncmp(argv[i], "--madvise=", 10) == 0) {
+			if (zio_parse_madv(argv[i] + 10, &zio.madv)) {
+				fprintf(stderr, "Invalid madvise hint\n");
+				return 1;
+			}
+		} else if (strcmp(argv[i], "--mmap-read=copy") == 0) {
+			zio.mmap_copy = true;
+			mmap_read = true;
+		} else if (strcmp(argv[i], "--mmap-read=checksum") == 0) {
+			zio.mmap_copy = false;
+			mmap_read = true;
+		} else if (strncmp(argv[i], "--mmap-read=", 12) == 0) {
+			fprintf(stderr, "Invalid mmap read mode\n");
+			return 1;
+		} else if (strcmp(argv[i], "--evict") == 0) {
+			zio.evict = true;
+		} else if (strncmp(argv[i], "--ra-hint=", 10) == 0) {
+			if (zio_parse_ra_hint(argv[i] + 10, &zio.ra_hint)) {
+				fprintf(stderr, "Invalid readahead hint\n");
+				return 1;
+			}
+			zio.cache_stats = true;
+		} else if (strncmp(argv[i], "--ra-window=", 12) == 0) {
+			arg = atoll(argv[i] + 12);
+			if (arg <= 0) {
+				fprintf(stderr, "Invalid readahead window\n");
+				return 1;
+			}
+			zio.ra_window = arg;
+			ra_window = true;
+		} else if (strncmp(argv[i], "--ra-sweep=", 11) == 0) {
+			if (sscanf(argv[i] + 11, "%zu-%zu", &jobs.ra_min,
+				   &jobs.ra_max) != 2 ||
+			    !jobs.ra_min || jobs.ra_min > jobs.ra_max ||
+			    jobs.ra_max > SIZE_MAX / 2) {
+				fprintf(stderr, "Invalid readahead sweep\n");
+				return 1;
+			}
+		} else if (strcmp(argv[i], "--fixed-bufs") == 0) {
+			zio.fixed_bufs = true;
+		} else if (strncmp(argv[i], "--mem=", 6) == 0) {
+			if (strcmp(argv[i] + 6, "malloc") == 0) {
+				zio.mem = ZIO_MEM_MALLOC;
+			} else if (strcmp(argv[i] + 6, "hugetlb") == 0) {
+				zio.mem = ZIO_MEM_HUGETLB;
+			} else if (strcmp(argv[i] + 6, "thp") == 0) {
+				zio.mem = ZIO_MEM_THP;
+			} else {
+				fprintf(stderr, "Invalid IO buffer memory\n");
+				return 1;
+			}
+		} else if (strncmp(argv[i], "--lat-hist=", 11) == 0) {
+			zio.lat_hist_path = argv[i] + 11;
+			if (!*zio.lat_hist_path) {
+				fprintf(stderr, "Invalid latency histogram file\n");
+				return 1;
+			}
+		} else if (strncmp(argv[i], "--jobs=", 7) == 0) {
+			arg = atoi(argv[i] + 7);
+			if (arg <= 0) {
+				fprintf(stderr, "Invalid number of jobs\n");
+				return 1;
+			}
+			jobs.nr_jobs = arg;
+		} else if (strncmp(argv[i], "--cpus=", 7) == 0) {
+			jobs.cpus_arg = argv[i] + 7;
+			if (zio_parse_cpus(&jobs, jobs.cpus_arg)) {
+				fprintf(stderr, "Invalid CPU list\n");
+				return 1;
+			}
+		} else if (strncmp(argv[i], "--numa-node=", 12) == 0) {
+			jobs.numa_node = atoi(argv[i] + 12);
+			if (jobs.numa_node < 0 || jobs.numa_node >= 1024) {
+				fprintf(stderr, "Invalid NUMA node\n");
+				return 1;
+			}
+		} else if (strncmp(argv[i], "--file-range=", 13) == 0) {
+			if (sscanf(argv[i] + 13, "%u-%u", &first, &last) != 2 ||
+			    first > last) {
+				fprintf(stderr, "Invalid file range\n");
+				return 1;
+			}
+			range = true;
+		} else if (strcmp(argv[i], "--rand=uniform") == 0) {
+			zio.rand = ZIO_RAND_UNIFORM;
+		} else if (strncmp(argv[i], "--rand=zipf", 11) == 0) {
+			zio.rand = ZIO_RAND_ZIPF;
+			zio.zipf_theta = 0.99;
+			if (argv[i][11] == ':')
+				zio.zipf_theta = atof(argv[i] + 12);
+			else if (argv[i][11])
+				zio.zipf_theta = 0;
+			if (zio.zipf_theta <= 0 || zio.zipf_theta >= 1) {
+				fprintf(stderr, "Invalid zipf theta\n");
+				return 1;
+			}
+		} else if (strncmp(argv[i], "--rand=hotspot", 14) == 0) {
+			zio.rand = ZIO_RAND_HOTSPOT;
+			zio.hot_pct = 10;
+			zio.hot_access_pct = 90;
+			if (argv[i][14] &&
+			    (sscanf(argv[i] + 14, ":%u:%u", &zio.hot_pct,
+				    &zio.hot_access_pct) != 2 ||
+			     !zio.hot_pct || zio.hot_pct > 100 ||
+			     zio.hot_access_pct > 100)) {
+				fprintf(stderr, "Invalid hot spot\n");
+				return 1;
+			}
+		} else if (strncmp(argv[i], "--rand=", 7) == 0) {
+			fprintf(stderr, "Invalid random distribution\n");
+			return 1;
+		} else if (strncmp(argv[i], "--rand-seed=", 12) == 0) {
+			zio.rand_seed = strtoull(argv[i] + 12, NULL, 0);
+		} else if (strncmp(argv[i], "--align=", 8) == 0) {
+			arg = atoll(argv[i] + 8);
+			if (arg <= 0) {
+				fprintf(stderr, "Invalid random IO alignment\n");
+				return 1;
+			}
+			zio.rand_align = arg;
+		} else if (strncmp(argv[i], "--wset=", 7) == 0) {
+			arg = atoll(argv[i] + 7);
+			if (arg <= 0) {
+				fprintf(stderr, "Invalid working set size\n");
+				return 1;
+			}
+			zio.rand_wset = arg;
+		} else if (strncmp(argv[i], "--rate-iops=", 12) == 0) {
+			rate_iops = atof(argv[i] + 12);
+			if (rate_iops <= 0) {
+				fprintf(stderr, "Invalid IOPS rate\n");
+				return 1;
+			}
+		} else if (strncmp(argv[i], "--rate-bw=", 10) == 0) {
+			rate_bw = atof(argv[i] + 10);
+			if (rate_bw <= 0) {
+				fprintf(stderr, "Invalid bandwidth rate\n");
+				return 1;
+			}
+		} else if (strcmp(argv[i], "--verify") == 0) {
+			zio.verify = true;
+			zio.verify_seed = 1;
+		} else if (strncmp(argv[i], "--verify=", 9) == 0) {
+			zio.verify = true;
+			zio.verify_seed = strtoull(argv[i] + 9, NULL, 0);
+		} else if (strncmp(argv[i], "--runtime=", 10) == 0) {
+			runtime = atof(argv[i] + 10);
+			if (runtime <= 0) {
+				fprintf(stderr, "Invalid run time\n");
+				return 1;
+			}
+		} else if (strncmp(argv[i], "--interval=", 11) == 0) {
+			interval = atof(argv[i] + 11);
+			if (interval <= 0) {
+				fprintf(stderr, "Invalid report interval\n");
+				return 1;
+			}
+			jobs.interval_ns = interval * 1000000000.0;
+		} else if (strcmp(argv[i], "--wrap") == 0) {
+			zio.wrap = true;
+		} else if (strncmp(argv[i], "--output-format=", 16) == 0) {
+			if (strcmp(argv[i] + 16, "normal") == 0) {
+				jobs.output = ZIO_OUTPUT_NORMAL;
+			} else if (strcmp(argv[i] + 16, "json") == 0) {
+				jobs.output = ZIO_OUTPUT_JSON;
+			} else if (strcmp(argv[i] + 16, "csv") == 0) {
+				jobs.output = ZIO_OUTPUT_CSV;
+			} else {
+				fprintf(stderr, "Invalid output format\n");
+				return 1;
+			}
+		} else if (strcmp(argv[i], "--shared-file") == 0) {
+			jobs.shared = true;
+		} else if (strncmp(argv[i], "--fflag=", 8) == 0) {
+			if (strcmp(argv[i] + 8, "direct") == 0) {
+				zio.fflags |= O_DIRECT;
+			} else if (strcmp(argv[i] + 8, "append") == 0) {
+				zio.fflags |= O_APPEND;
+			} else if (strcmp(argv[i] + 8, "ndelay") == 0) {
+				zio.fflags |= O_NDELAY;
+			} else if (strcmp(argv[i] + 8, "sync") == 0) {
+				zio.fflags |= O_SYNC;
+			} else if (strcmp(argv[i] + 8, "dsync") == 0) {
+				zio.fflags |= O_DSYNC;
 			} else if (strcmp(argv[i] + 8, "trunc") == 0) {
 				zio.fflags |= O_TRUNC;
 			} else {
@@ -597,36 +1943,204 @@ int main(int argc, char **argv)
 		} else if (argv[i][0] == '-') {
 			fprintf(stderr, "Invalid option \"%s\"\n", argv[i]);
 			return 1;
+		} else {
+			paths[nr_paths++] = argv[i];
 		}
 	}
 
-	ret = zio_init(&zio, argv[argc - 1]);
-	if (ret != 0)
+	if (!nr_paths) {
+		fprintf(stderr, "No file specified\n");
 		return 1;
+	}
 
-	start = zio_usec();
+	/* Without an explicit engine, --async selects the aio engine */
+	if (!engine_set && zio.async)
+		zio.engine = ZIO_ENGINE_AIO;
+	if ((zio.engine == ZIO_ENGINE_SYNC || zio.engine == ZIO_ENGINE_MMAP) &&
+	    zio.async) {
+		fprintf(stderr, "--async cannot be used with the %s engine\n",
+			zio_engine_name(zio.engine));
+		return 1;
+	}
+	if (zio.engine == ZIO_ENGINE_MMAP && (!zio.read || zio.iovec)) {
+		fprintf(stderr,
+			"The mmap engine cannot be used with --write or --iovec\n");
+		return 1;
+	}
+	if ((zio.madv || mmap_read) && zio.engine != ZIO_ENGINE_MMAP) {
+		fprintf(stderr,
+			"--madvise and --mmap-read require the mmap engine\n");
+		return 1;
+	}
+	if ((zio.evict || zio.cache_stats || ra_window || jobs.ra_min) &&
+	    !zio.read) {
+		fprintf(stderr,
+			"--evict, --ra-hint, --ra-window and --ra-sweep require --read\n");
+		return 1;
+	}
+	if ((zio.cache_stats || ra_window || jobs.ra_min) &&
+	    (zio.engine != ZIO_ENGINE_SYNC || (zio.fflags & O_DIRECT))) {
+		fprintf(stderr,
+			"--ra-hint, --ra-window and --ra-sweep require buffered reads with the sync engine\n");
+		return 1;
+	}
+	if ((ra_window || jobs.ra_min) &&
+	    zio.ra_hint != ZIO_RA_WILLNEED && zio.ra_hint != ZIO_RA_READAHEAD) {
+		fprintf(stderr,
+			"--ra-window and --ra-sweep require --ra-hint=willneed or --ra-hint=readahead\n");
+		return 1;
+	}
+	if (jobs.ra_min && (runtime || interval || zio.lat_hist_path)) {
+		fprintf(stderr,
+			"--ra-sweep cannot be used with --runtime, --interval or --lat-hist\n");
+		return 1;
+	}
+
+	/* With the uring engine, RWF_HIPRI requires a polled ring */
+	if (zio.engine == ZIO_ENGINE_URING && (zio.ioflags & RWF_HIPRI) &&
+	    !zio.poll)
+		zio.poll = ZIO_POLL_BUSY;
+	if ((zio.sqpoll || zio.fixed_files || zio.fixed_bufs || zio.poll) &&
+	    zio.engine != ZIO_ENGINE_URING) {
+		fprintf(stderr,
+			"--sqpoll, --fixed-files, --fixed-bufs and --poll require the uring engine\n");
+		return 1;
+	}
+	if (zio.fixed_bufs && zio.iovec) {
+		fprintf(stderr, "--fixed-bufs cannot be used with --iovec\n");
+		return 1;
+	}
+	if (zio.poll && !(zio.fflags & O_DIRECT)) {
+		fprintf(stderr, "--poll requires --fflag=direct\n");
+		return 1;
+	}
+
+	if (zio.verify && jobs.shared && !zio.read) {
+		fprintf(stderr,
+			"--verify cannot be used with --shared-file writes\n");
+		return 1;
+	}
+
+	if (zio.rand && !zio.read &&
+	    ((zio.fflags & O_APPEND) || (zio.ioflags & RWF_APPEND))) {
+		fprintf(stderr, "--rand cannot be used with append writes\n");
+		return 1;
+	}
+	if ((zio.rand_align || zio.rand_wset) && !zio.rand) {
+		fprintf(stderr, "--align and --wset require --rand\n");
+		return 1;
+	}
+
+	if (zio.wrap && !runtime) {
+		fprintf(stderr, "--wrap requires --runtime\n");
+		return 1;
+	}
+	if (zio.wrap && jobs.shared && !zio.read) {
+		fprintf(stderr,
+			"--wrap cannot be used with --shared-file writes\n");
+		return 1;
+	}
+
+	if (rate_iops && rate_bw) {
+		fprintf(stderr,
+			"--rate-iops and --rate-bw cannot be used together\n");
+		return 1;
+	}
+	if (rate_bw)
+		rate_iops = rate_bw * 1000000.0 / zio.iosize;
+
+	if (!zio.batch_max || zio.batch_max > zio.iodepth)
+		zio.batch_max = zio.iodepth;
+	if (!zio.batch_min)
+		zio.batch_min = 1;
+	if (zio.batch_min > zio.batch_max) {
+		fprintf(stderr, "Invalid batch size (%u to %u)\n",
+			zio.batch_min, zio.batch_max);
+		return 1;
+	}
+
+	ret = zio_get_files(&jobs, paths, nr_paths, range, first, last);
+	free(paths);
+	if (ret) {
+		ret = 1;
+		goto out;
+	}
+
+	/* Without CPU lists, run jobs on the CPUs of the NUMA node */
+	if (jobs.numa_node >= 0) {
+		cpu_set_t node_cpus;
 
-	if (zio.async)
-		ret = zio_run_async(&zio);
-	else
-		ret = zio_run_sync(&zio);
+		if (zio_node_cpus(jobs.numa_node, &node_cpus)) {
+			ret = 1;
+			goto out;
+		}
+		if (!jobs.nr_cpus) {
+			jobs.cpus = malloc(sizeof(cpu_set_t));
+			if (!jobs.cpus) {
+				fprintf(stderr, "No memory for CPU list\n");
+				ret = 1;
+				goto out;
+			}
+			*jobs.cpus = node_cpus;
+			jobs.nr_cpus = 1;
+		}
+	}
+
+	zio_get_dev(&jobs, jobs.files[0]);
+
+	if (jobs.shared) {
+		ret = zio_prep_shared(&jobs);
+		if (ret) {
+			ret = 1;
+			goto out;
+		}
+	} else if (jobs.nr_jobs > jobs.nr_files) {
+		/* There is no point in having more jobs than files */
+		jobs.nr_jobs = jobs.nr_files;
+	}
+
+	/* The target rate is shared evenly between jobs */
+	if (rate_iops)
+		zio.rate_ns = 1000000000.0 * jobs.nr_jobs / rate_iops;
+
+	if (jobs.ra_min) {
+		ret = zio_ra_sweep(&jobs, rate_iops) ? 1 : 0;
+		goto out;
+	}
+
+	ret = zio_run_pass(&jobs, &res, rate_iops, runtime);
 	if (ret != 0)
 		ret = 1;
 
 	if (ret == 0) {
-		unsigned long long elapsed = zio_usec() - start;
-		unsigned long long bw, iops;
+		zio_get_placement(&jobs);
+
+		switch (jobs.output) {
+		case ZIO_OUTPUT_JSON:
+			zio_output_json(&jobs, &res);
+			break;
+		case ZIO_OUTPUT_CSV:
+			zio_output_csv(&jobs, &res);
+			break;
+		case ZIO_OUTPUT_NORMAL:
+		default:
+			zio_print_result(&jobs, &res);
+			break;
+		}
 
-		iops = zio.nr_ios * 1000000ULL / elapsed;
-		bw = zio.nr_ios * zio.iosize * 1000000ULL / elapsed;
+		if (zio.verify && zio.read && res.st.nr_verify_errors)
+			ret = 1;
+		if (jobs.shared && !zio.read &&
+		    zio_check_shared(&jobs, &res.st))
+			ret = 1;
 
-		printf("%u IOs done in %llu ms (%llu us)\n",
-		       zio.nr_ios, elapsed / 1000, elapsed);
-		printf("    %llu IOPS, %llu.%03llu MB/s\n",
-		       iops, bw / 1000000, (bw % 1000000) / 1000);
+		if (zio.lat_hist_path &&
+		    zio_hist_dump(&res.st.lat, zio.lat_hist_path))
+			ret = 1;
 	}
 
-	zio_cleanup(&zio);
+out:
+	zio_put_files(&jobs);
 
 	return ret;
 }
@@ -0,0 +1,598 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (C) 2019 Western Digital Corporation or its affiliates.
+ * Author: Damien Le Moal <damien.lemoal@wdc.com>
+ */
+#ifndef ZIO_H
+#define ZIO_H
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <linux/aio_abi.h>
+#include <linux/fs.h>
+
+/*
+ * IO descriptor.
+ */
+struct zio {
+	int nr;
+	loff_t ofst;
+	unsigned long long issue_ns;
+	void *buf;
+	struct iovec *iov;
+        struct iocb iocb;
+};
+
+/*
+ * Log-linear latency histogram (nanoseconds).
+ */
+#define ZIO_HIST_SUB_BITS	6
+#define ZIO_HIST_SUB		(1U << ZIO_HIST_SUB_BITS)
+#define ZIO_HIST_NR_BUCKETS	((64 - ZIO_HIST_SUB_BITS + 1) * ZIO_HIST_SUB)
+
+struct zio_hist {
+	unsigned long long nr;
+	unsigned long long sum;
+	unsigned long long min;
+	unsigned long long max;
+	unsigned long long buckets[ZIO_HIST_NR_BUCKETS];
+};
+
+void zio_hist_init(struct zio_hist *h);
+void zio_hist_add(struct zio_hist *h, unsigned long long v);
+void zio_hist_merge(struct zio_hist *h, struct zio_hist *from);
+void zio_hist_sub(struct zio_hist *h, struct zio_hist *from);
+unsigned long long zio_hist_pct(struct zio_hist *h, double pct);
+void zio_hist_print(FILE *f, struct zio_hist *h, const char *indent);
+int zio_hist_dump(struct zio_hist *h, const char *path);
+
+/*
+ * IO engines.
+ */
+enum zio_engine {
+	ZIO_ENGINE_SYNC,	/* preadv2/pwritev2 */
+	ZIO_ENGINE_AIO,		/* Linux native AIO */
+	ZIO_ENGINE_URING,	/* io_uring */
+	ZIO_ENGINE_MMAP,	/* Reads from a file mapping */
+};
+
+/*
+ * madvise() hints of the mmap engine.
+ */
+#define ZIO_MADV_SEQ		(1U << 0)
+#define ZIO_MADV_RANDOM		(1U << 1)
+#define ZIO_MADV_WILLNEED	(1U << 2)
+#define ZIO_MADV_HUGEPAGE	(1U << 3)
+
+/*
+ * Readahead hints of buffered reads with the sync engine.
+ */
+enum zio_ra_hint {
+	ZIO_RA_NONE,		/* Kernel readahead */
+	ZIO_RA_SEQ,		/* POSIX_FADV_SEQUENTIAL */
+	ZIO_RA_RANDOM,		/* POSIX_FADV_RANDOM */
+	ZIO_RA_WILLNEED,	/* POSIX_FADV_WILLNEED windows */
+	ZIO_RA_READAHEAD,	/* readahead() windows */
+};
+
+/*
+ * IO completion polling, with the uring engine.
+ */
+enum zio_poll {
+	ZIO_POLL_NONE,		/* Interrupt driven completions */
+	ZIO_POLL_BUSY,		/* IORING_SETUP_IOPOLL */
+	ZIO_POLL_HYBRID,	/* IOPOLL, sleeping before polling */
+};
+
+/*
+ * IO buffers memory.
+ */
+enum zio_mem {
+	ZIO_MEM_MALLOC,		/* One aligned allocation per IO slot */
+	ZIO_MEM_HUGETLB,	/* Pool of MAP_HUGETLB pages */
+	ZIO_MEM_THP,		/* Pool of transparent huge pages */
+};
+
+/*
+ * Pool of IO buffers, one per IO slot, carved from a single huge page
+ * backed allocation.
+ */
+struct zio_pool {
+	enum zio_mem mem;
+	void *base;
+	size_t size;
+	size_t hpsz;
+	size_t slot_size;
+	unsigned int nr_slots;
+};
+
+/*
+ * Zipf zeta(n) of a job, kept across the files of the job so that it is
+ * computed only when the number of random IO blocks changes.
+ */
+struct zio_zeta {
+	unsigned long long n;
+	double zetan;
+};
+
+struct zio_uring;
+struct zio_live;
+
+/*
+ * Result output formats.
+ */
+enum zio_output {
+	ZIO_OUTPUT_NORMAL,	/* Human readable */
+	ZIO_OUTPUT_JSON,
+	ZIO_OUTPUT_CSV,
+};
+
+/*
+ * Random IO offset distributions.
+ */
+enum zio_rand {
+	ZIO_RAND_NONE,		/* Sequential IOs */
+	ZIO_RAND_UNIFORM,
+	ZIO_RAND_ZIPF,
+	ZIO_RAND_HOTSPOT,
+};
+
+/*
+ * Run parameters.
+ */
+struct zio_params {
+	bool verbose;
+	unsigned int job;
+	char *path;
+	int fd;
+	unsigned long long ino;
+
+	bool read;
+	bool iovec;
+	bool async;
+	enum zio_engine engine;
+
+	int fflags;
+	bool append;
+	loff_t fsize;
+	loff_t fmaxsize;
+	size_t blksize;
+
+	size_t iosize;
+	loff_t ioofst;
+	unsigned int iovcnt;
+	unsigned int iovlen;
+	unsigned int ionum;
+	int ioflags;
+	unsigned int iodepth;
+	struct zio *io;
+
+	/* IO buffers */
+	enum zio_mem mem;
+	size_t buf_size;
+	struct zio_pool *pool;
+
+	aio_context_t ioctx;
+        struct iocb **iocbs;
+	struct io_event *events;
+
+	/* Async IO completion batch size */
+	unsigned int batch_min;
+	unsigned int batch_max;
+
+	/* io_uring engine */
+	struct zio_uring *uring;
+	bool sqpoll;
+	unsigned int sqpoll_idle;
+	bool fixed_files;
+	bool fixed_bufs;
+	enum zio_poll poll;
+
+	/* mmap engine */
+	unsigned int madv;
+	bool mmap_copy;
+	unsigned long long mmap_sum;
+
+	/* Page cache eviction, readahead hints and page cache hits */
+	bool evict;
+	bool cache_stats;
+	enum zio_ra_hint ra_hint;
+	size_t ra_window;
+	loff_t ra_start;
+	loff_t ra_end;
+	void *cache_map;
+	unsigned char *cache_vec;
+	unsigned long long nr_cache_hits;
+	unsigned long long nr_cache_lookups;
+
+	unsigned int nr_ios;
+	unsigned long long nr_syscalls;
+
+	/* IO latency */
+	struct zio_hist lat;
+	char *lat_hist_path;
+
+	/* Data verification */
+	bool verify;
+	unsigned long long verify_seed;
+	unsigned long long nr_verified;
+	unsigned long long nr_verify_errors;
+
+	/* Random IOs */
+	enum zio_rand rand;
+	unsigned long long rand_seed;
+	unsigned long long rand_state;
+	unsigned long long rand_nr_blks;
+	size_t rand_align;
+	loff_t rand_wset;
+	double zipf_theta;
+	double zipf_zetan;
+	double zipf_alpha;
+	double zipf_eta;
+	struct zio_zeta *zeta;
+	unsigned int hot_pct;
+	unsigned int hot_access_pct;
+
+	/* Time-based runs and live statistics */
+	unsigned long long deadline;
+	bool wrap;
+	struct zio_live *live;
+
+	/* Open-loop rate limit: time between IOs and issue lag */
+	double rate_ns;
+	unsigned long long rate_start;
+	unsigned long long rate_lag_sum;
+	unsigned long long rate_lag_max;
+};
+
+/*
+ * Accumulated statistics of the runs of a job.
+ */
+struct zio_stats {
+	unsigned int nr_files;
+	unsigned long long nr_ios;
+	unsigned long long nr_bytes;
+	unsigned long long nr_syscalls;
+	unsigned long long nr_verified;
+	unsigned long long nr_verify_errors;
+	unsigned long long rate_lag_sum;
+	unsigned long long rate_lag_max;
+	unsigned long long mmap_sum;
+	unsigned long long nr_cache_hits;
+	unsigned long long nr_cache_lookups;
+	struct zio_hist lat;
+};
+
+/*
+ * Cumulative statistics of a job, for reporting while the job runs. They
+ * are updated only by the job thread. The IO and byte counters are always
+ * maintained, for SIGUSR1. The latency histogram is maintained only with
+ * interval reports and is read under the seq sequence count, which is odd
+ * while the job updates the statistics.
+ */
+struct zio_live {
+	bool hist;
+	unsigned int seq;
+	unsigned long long nr_ios;
+	unsigned long long nr_bytes;
+	struct zio_hist lat;
+};
+
+/*
+ * Statistics of a report interval.
+ */
+struct zio_sample {
+	unsigned long long time;
+	unsigned long long duration;
+	unsigned long long nr_ios;
+	unsigned long long nr_bytes;
+	unsigned long long p50;
+	unsigned long long p99;
+	unsigned long long max;
+};
+
+/*
+ * Placement of a job: the CPU it last ran on, the device hardware queue
+ * mapped to that CPU and the device interrupts with an affinity including
+ * that CPU.
+ */
+#define ZIO_MAX_IRQS	8
+
+struct zio_irq {
+	int irq;
+	char cpus[256];
+};
+
+struct zio_place {
+	int cpu;
+	int hwq;
+	char hwq_cpus[256];
+	unsigned int nr_irqs;
+	struct zio_irq irqs[ZIO_MAX_IRQS];
+};
+
+/*
+ * Block device holding the files.
+ */
+struct zio_dev {
+	char name[64];
+	char sysfs[PATH_MAX];
+	char numa_dir[PATH_MAX];
+	char irq_dir[PATH_MAX];
+	int numa_node;
+};
+
+/*
+ * Job: a worker thread doing IOs on the files of the job list, one file
+ * at a time, with its own run parameters, IO context and buffers.
+ */
+struct zio_jobs;
+
+struct zio_job {
+	unsigned int id;
+	pthread_t thread;
+	struct zio_jobs *jobs;
+	struct zio_params zio;
+	struct zio_stats stats;
+	struct zio_live live;
+	struct zio_pool pool;
+	struct zio_zeta zeta;
+	struct zio_place place;
+	unsigned long long elapsed;
+	int ret;
+};
+
+struct zio_jobs {
+	/* Run parameters template */
+	struct zio_params *zio;
+
+	/* Files, taken in order by the jobs */
+	char **files;
+	unsigned int nr_files;
+	unsigned int next_file;
+	bool abort;
+
+	/* All jobs do IOs to the same file */
+	bool shared;
+	loff_t shared_fsize;
+
+	unsigned int nr_jobs;
+	struct zio_job *job;
+
+	/* Running jobs, signaled when the last job ends */
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	unsigned int nr_running;
+
+	/* Periodic statistics report */
+	unsigned long long interval_ns;
+	struct zio_sample *samples;
+	unsigned int nr_samples;
+
+	enum zio_output output;
+
+	/* CPU lists used in turn by jobs, memory NUMA node */
+	char *cpus_arg;
+	cpu_set_t *cpus;
+	unsigned int nr_cpus;
+	int numa_node;
+	struct zio_dev dev;
+
+	/* Readahead window sweep */
+	size_t ra_min;
+	size_t ra_max;
+};
+
+/*
+ * Results of a run, for all jobs.
+ */
+struct zio_result {
+	struct zio_stats st;
+	unsigned long long elapsed;	/* us */
+	unsigned long long iops;
+	unsigned long long bw;		/* B/s */
+	unsigned long long cpu_usr;	/* us */
+	unsigned long long cpu_sys;	/* us */
+	unsigned long long minflt;
+	unsigned long long majflt;
+	double rate_iops;
+	double runtime;			/* s */
+};
+
+/*
+ * Results of a readahead window sweep pass.
+ */
+struct zio_ra_pass {
+	size_t window;
+	bool cold;
+	struct zio_result res;
+};
+
+/*
+ * Utilities.
+ */
+#define zio_vprintf(zio,format,args...)		\
+	if ((zio)->verbose) {			\
+                printf(format, ## args);	\
+        }
+
+static inline unsigned long long zio_nsec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static inline unsigned long long zio_usec(void)
+{
+	return zio_nsec() / 1000;
+}
+
+/*
+ * With a rate limit, return the time at which the next IO is due.
+ */
+static inline unsigned long long zio_rate_next(struct zio_params *zio)
+{
+	return zio->rate_start +
+		(unsigned long long)(zio->nr_ios * zio->rate_ns);
+}
+
+static inline bool zio_io_due(struct zio_params *zio, unsigned long long now)
+{
+	return !zio->rate_ns || zio_rate_next(zio) <= now;
+}
+
+/*
+ * Set the issue time of an IO submitted at now. With a rate limit, the
+ * IO latency is measured from the time the IO was due, set when the IO
+ * was prepared, so that IOs delayed by slow completions are accounted
+ * for, and the lag behind the schedule is recorded.
+ */
+static inline void zio_io_issue(struct zio_params *zio, struct zio *io,
+				unsigned long long now)
+{
+	unsigned long long lag = 0;
+
+	if (!zio->rate_ns) {
+		io->issue_ns = now;
+		return;
+	}
+
+	if (now > io->issue_ns)
+		lag = now - io->issue_ns;
+	zio->rate_lag_sum += lag;
+	if (lag > zio->rate_lag_max)
+		zio->rate_lag_max = lag;
+}
+
+/*
+ * Account a completed IO in the live statistics of a job. The stores are
+ * done with relaxed atomics so that the reporting thread can read the
+ * counters at any time, without a lock.
+ */
+static inline void zio_live_add(struct zio_live *live, size_t iosize,
+				unsigned long long lat)
+{
+	if (live->hist) {
+		__atomic_store_n(&live->seq, live->seq + 1, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+	}
+
+	__atomic_store_n(&live->nr_ios, live->nr_ios + 1, __ATOMIC_RELAXED);
+	__atomic_store_n(&live->nr_bytes, live->nr_bytes + iosize,
+			 __ATOMIC_RELAXED);
+
+	if (live->hist) {
+		zio_hist_add(&live->lat, lat);
+		__atomic_store_n(&live->seq, live->seq + 1, __ATOMIC_RELEASE);
+	}
+}
+
+/*
+ * With random IOs, choose the offset of the next IO.
+ */
+loff_t zio_rand_ofst(struct zio_params *zio);
+
+static inline void zio_next_ofst(struct zio_params *zio)
+{
+	if (zio->rand)
+		zio->ioofst = zio_rand_ofst(zio);
+}
+
+/*
+ * Record the latency of a completed IO.
+ */
+static inline void zio_io_done(struct zio_params *zio, struct zio *io,
+			       unsigned long long now)
+{
+	zio_hist_add(&zio->lat, now - io->issue_ns);
+	if (zio->live)
+		zio_live_add(zio->live, zio->iosize, now - io->issue_ns);
+}
+
+static inline bool zio_done(struct zio_params *zio)
+{
+	if (zio->deadline && zio_nsec() >= zio->deadline)
+		return true;
+
+	if (zio->ionum)
+		return zio->nr_ios >= zio->ionum;
+
+	return (zio->read && zio->ioofst >= zio->fsize) ||
+		(!zio->read && zio->ioofst >= zio->fmaxsize);
+}
+
+void zio_stats_init(struct zio_stats *st);
+void zio_stats_add(struct zio_stats *st, struct zio_params *zio);
+void zio_stats_merge(struct zio_stats *st, struct zio_stats *from);
+void zio_live_init(struct zio_live *live, bool hist);
+void zio_live_read(struct zio_live *live, struct zio_stats *st);
+
+int zio_rand_init(struct zio_params *zio, loff_t size);
+
+int zio_verify_init(struct zio_params *zio);
+void zio_verify_fill(struct zio_params *zio, struct zio *io, loff_t ofst);
+void zio_verify_check(struct zio_params *zio, struct zio *io, loff_t ofst,
+		      size_t len);
+
+void zio_wait_until(unsigned long long ns);
+int zio_run_uring(struct zio_params *zio);
+
+int zio_parse_madv(const char *name, unsigned int *madv);
+void zio_print_madv(FILE *f, unsigned int madv, const char *sep);
+int zio_run_mmap(struct zio_params *zio);
+
+int zio_parse_ra_hint(const char *name, enum zio_ra_hint *hint);
+const char *zio_ra_hint_name(enum zio_ra_hint hint);
+int zio_cache_init(struct zio_params *zio);
+void zio_cache_cleanup(struct zio_params *zio);
+int zio_cache_prep_read(struct zio_params *zio, loff_t ofst, size_t len);
+unsigned long long zio_cache_hit_pct(struct zio_stats *st);
+void zio_print_cache(struct zio_params *zio, struct zio_stats *st);
+
+const char *zio_engine_name(enum zio_engine engine);
+const char *zio_mem_name(enum zio_mem mem);
+
+int zio_parse_cpulist(const char *s, cpu_set_t *set);
+int zio_node_cpus(int node, cpu_set_t *set);
+int zio_job_place(struct zio_job *job);
+void zio_get_dev(struct zio_jobs *jobs, const char *file);
+void zio_get_placement(struct zio_jobs *jobs);
+void zio_print_placement(struct zio_jobs *jobs);
+
+int zio_pool_alloc(struct zio_pool *pool, enum zio_mem mem,
+		   size_t slot_size, unsigned int nr_slots);
+void *zio_pool_slot(struct zio_pool *pool, unsigned int idx);
+void zio_pool_free(struct zio_pool *pool);
+const char *zio_poll_name(enum zio_poll poll);
+void zio_output_json(struct zio_jobs *jobs, struct zio_result *res);
+void zio_output_csv(struct zio_jobs *jobs, struct zio_result *res);
+void zio_output_sweep_json(struct zio_jobs *jobs, struct zio_ra_pass *pass,
+			   unsigned int nr_passes);
+void zio_output_sweep_csv(struct zio_jobs *jobs, struct zio_ra_pass *pass,
+			  unsigned int nr_passes);
+
+#endif /* ZIO_H */
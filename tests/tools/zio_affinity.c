@@ -0,0 +1,296 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (C) 2026 Western Digital Corporation or its affiliates.
+ */
+
+#include "zio.h"
+
+#include <dirent.h>
+#include <sys/sysmacros.h>
+#include <linux/mempolicy.h>
+
+/*
+ * Parse a CPU list such as "0-3,8,10-11".
+ */
+int zio_parse_cpulist(const char *s, cpu_set_t *set)
+{
+	unsigned int first, last, cpu;
+	char *end;
+
+	CPU_ZERO(set);
+
+	while (*s && *s != '\n') {
+		first = strtoul(s, &end, 10);
+		if (end == s)
+			return -1;
+		last = first;
+		s = end;
+		if (*s == '-') {
+			s++;
+			last = strtoul(s, &end, 10);
+			if (end == s || last < first)
+				return -1;
+			s = end;
+		}
+		if (last >= CPU_SETSIZE)
+			return -1;
+		for (cpu = first; cpu <= last; cpu++)
+			CPU_SET(cpu, set);
+		if (*s == ',')
+			s++;
+		else if (*s && *s != '\n')
+			return -1;
+	}
+
+	return CPU_COUNT(set) ? 0 : -1;
+}
+
+/*
+ * Read the first line of a sysfs or procfs file, without the new line.
+ */
+static int zio_read_line(const char *path, char *buf, size_t len)
+{
+	FILE *f;
+	char *p;
+
+	f = fopen(path, "r");
+	if (!f)
+		return -1;
+
+	p = fgets(buf, len, f);
+	fclose(f);
+	if (!p)
+		return -1;
+
+	buf[strcspn(buf, "\n")] = '\0';
+
+	return 0;
+}
+
+static bool zio_cpulist_has(const char *list, int cpu)
+{
+	cpu_set_t set;
+
+	if (cpu < 0 || zio_parse_cpulist(list, &set))
+		return false;
+
+	return CPU_ISSET(cpu, &set);
+}
+
+/*
+ * Get the CPUs of a NUMA node.
+ */
+int zio_node_cpus(int node, cpu_set_t *set)
+{
+	char path[PATH_MAX], list[1024];
+
+	snprintf(path, sizeof(path),
+		 "/sys/devices/system/node/node%d/cpulist", node);
+	if (zio_read_line(path, list, sizeof(list)) ||
+	    zio_parse_cpulist(list, set)) {
+		fprintf(stderr, "Invalid NUMA node %d\n", node);
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Pin the calling job thread to its CPU list and bind its memory
+ * allocations to the NUMA node, if specified. Jobs use the CPU lists in
+ * turn.
+ */
+int zio_job_place(struct zio_job *job)
+{
+	struct zio_jobs *jobs = job->jobs;
+	unsigned long nodemask[1024 / (8 * sizeof(unsigned long))] = { };
+	int ret;
+
+	if (jobs->nr_cpus) {
+		ret = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t),
+					     &jobs->cpus[job->id % jobs->nr_cpus]);
+		if (ret) {
+			fprintf(stderr, "Job %u: set CPU affinity failed %d (%s)\n",
+				job->id, ret, strerror(ret));
+			return -1;
+		}
+	}
+
+	if (jobs->numa_node >= 0) {
+		nodemask[jobs->numa_node / (8 * sizeof(unsigned long))] |=
+			1UL << (jobs->numa_node % (8 * sizeof(unsigned long)));
+		if (syscall(SYS_set_mempolicy, MPOL_BIND, nodemask,
+			    sizeof(nodemask) * 8)) {
+			fprintf(stderr, "Job %u: bind to node %d failed %d (%s)\n",
+				job->id, jobs->numa_node, errno,
+				strerror(errno));
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Walk up the sysfs device path from dir and return in dir the first
+ * directory containing name.
+ */
+static int zio_sysfs_find_up(char *dir, const char *name)
+{
+	char path[PATH_MAX + 64];
+	char *p;
+
+	while (strcmp(dir, "/sys/devices") != 0) {
+		snprintf(path, sizeof(path), "%s/%s", dir, name);
+		if (access(path, F_OK) == 0)
+			return 0;
+		p = strrchr(dir, '/');
+		if (!p || p == dir)
+			break;
+		*p = '\0';
+	}
+
+	return -1;
+}
+
+/*
+ * Get the block device holding a file, its NUMA node and the sysfs
+ * directory of its MSI interrupts.
+ */
+void zio_get_dev(struct zio_jobs *jobs, const char *file)
+{
+	struct zio_dev *dev = &jobs->dev;
+	char path[PATH_MAX + 64], node[32];
+	struct stat st;
+	char *p;
+
+	memset(dev, 0, sizeof(*dev));
+	dev->numa_node = -1;
+
+	if (stat(file, &st))
+		return;
+
+	/* Use the whole disk of partitions */
+	snprintf(path, sizeof(path), "/sys/dev/block/%u:%u",
+		 major(st.st_dev), minor(st.st_dev));
+	if (!realpath(path, dev->sysfs))
+		return;
+	snprintf(path, sizeof(path), "%s/partition", dev->sysfs);
+	if (access(path, F_OK) == 0) {
+		p = strrchr(dev->sysfs, '/');
+		if (p)
+			*p = '\0';
+	}
+
+	p = strrchr(dev->sysfs, '/');
+	snprintf(dev->name, sizeof(dev->name), "%.*s",
+		 (int)sizeof(dev->name) - 1, p ? p + 1 : dev->sysfs);
+
+	/* Virtual devices have no NUMA node nor interrupts */
+	snprintf(path, sizeof(path), "%s/device", dev->sysfs);
+	if (!realpath(path, dev->irq_dir))
+		return;
+	snprintf(dev->numa_dir, sizeof(dev->numa_dir), "%s", dev->irq_dir);
+
+	if (zio_sysfs_find_up(dev->numa_dir, "numa_node") == 0) {
+		snprintf(path, sizeof(path), "%s/numa_node", dev->numa_dir);
+		if (zio_read_line(path, node, sizeof(node)) == 0)
+			dev->numa_node = atoi(node);
+	}
+
+	if (zio_sysfs_find_up(dev->irq_dir, "msi_irqs"))
+		dev->irq_dir[0] = '\0';
+}
+
+/*
+ * Find the hardware queue mapped to the CPU a job ran on, and the device
+ * interrupts with an affinity including that CPU.
+ */
+static void zio_get_job_place(struct zio_dev *dev, struct zio_place *place)
+{
+	char path[PATH_MAX + 512];
+	struct dirent *d;
+	DIR *dir;
+
+	place->hwq = -1;
+	place->nr_irqs = 0;
+
+	snprintf(path, sizeof(path), "%s/mq", dev->sysfs);
+	dir = opendir(path);
+	while (dir && (d = readdir(dir))) {
+		if (d->d_name[0] == '.')
+			continue;
+		snprintf(path, sizeof(path), "%s/mq/%s/cpu_list",
+			 dev->sysfs, d->d_name);
+		if (zio_read_line(path, place->hwq_cpus,
+				  sizeof(place->hwq_cpus)) == 0 &&
+		    zio_cpulist_has(place->hwq_cpus, place->cpu)) {
+			place->hwq = atoi(d->d_name);
+			break;
+		}
+	}
+	if (dir)
+		closedir(dir);
+
+	if (!dev->irq_dir[0])
+		return;
+
+	snprintf(path, sizeof(path), "%s/msi_irqs", dev->irq_dir);
+	dir = opendir(path);
+	while (dir && (d = readdir(dir)) && place->nr_irqs < ZIO_MAX_IRQS) {
+		struct zio_irq *irq = &place->irqs[place->nr_irqs];
+
+		if (d->d_name[0] == '.')
+			continue;
+		irq->irq = atoi(d->d_name);
+		snprintf(path, sizeof(path),
+			 "/proc/irq/%d/effective_affinity_list", irq->irq);
+		if (zio_read_line(path, irq->cpus, sizeof(irq->cpus))) {
+			snprintf(path, sizeof(path),
+				 "/proc/irq/%d/smp_affinity_list", irq->irq);
+			if (zio_read_line(path, irq->cpus, sizeof(irq->cpus)))
+				continue;
+		}
+		if (zio_cpulist_has(irq->cpus, place->cpu))
+			place->nr_irqs++;
+	}
+	if (dir)
+		closedir(dir);
+}
+
+void zio_get_placement(struct zio_jobs *jobs)
+{
+	unsigned int i;
+
+	for (i = 0; i < jobs->nr_jobs; i++)
+		zio_get_job_place(&jobs->dev, &jobs->job[i].place);
+}
+
+/*
+ * Print the device NUMA node and, for each job, the CPU it ran on with the
+ * hardware queue and interrupts serving that CPU.
+ */
+void zio_print_placement(struct zio_jobs *jobs)
+{
+	struct zio_place *place;
+	unsigned int i, j;
+
+	if (!jobs->dev.name[0])
+		return;
+
+	printf("    Device %s: NUMA node %d\n",
+	       jobs->dev.name, jobs->dev.numa_node);
+
+	for (i = 0; i < jobs->nr_jobs; i++) {
+		place = &jobs->job[i].place;
+		printf("    Job %u placement: CPU %d",
+		       jobs->job[i].id, place->cpu);
+		if (place->hwq >= 0)
+			printf(", hw queue %d (CPUs %s)",
+			       place->hwq, place->hwq_cpus);
+		for (j = 0; j < place->nr_irqs; j++)
+			printf(", IRQ %d (CPUs %s)",
+			       place->irqs[j].irq, place->irqs[j].cpus);
+		printf("\n");
+	}
+}
@@ -0,0 +1,234 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (C) 2026 Western Digital Corporation or its affiliates.
+ */
+
+#include "zio.h"
+
+#include <sys/mman.h>
+
+static const struct {
+	enum zio_ra_hint hint;
+	const char *name;
+} zio_ra_hints[] = {
+	{ ZIO_RA_NONE,		"none" },
+	{ ZIO_RA_SEQ,		"sequential" },
+	{ ZIO_RA_RANDOM,	"random" },
+	{ ZIO_RA_WILLNEED,	"willneed" },
+	{ ZIO_RA_READAHEAD,	"readahead" },
+};
+
+#define ZIO_NR_RA_HINTS	(sizeof(zio_ra_hints) / sizeof(zio_ra_hints[0]))
+
+/*
+ * Parse a readahead hint name.
+ */
+int zio_parse_ra_hint(const char *name, enum zio_ra_hint *hint)
+{
+	unsigned int i;
+
+	for (i = 0; i < ZIO_NR_RA_HINTS; i++) {
+		if (strcmp(name, zio_ra_hints[i].name) == 0) {
+			*hint = zio_ra_hints[i].hint;
+			return 0;
+		}
+	}
+
+	return -1;
+}
+
+const char *zio_ra_hint_name(enum zio_ra_hint hint)
+{
+	unsigned int i;
+
+	for (i = 0; i < ZIO_NR_RA_HINTS; i++) {
+		if (zio_ra_hints[i].hint == hint)
+			return zio_ra_hints[i].name;
+	}
+
+	return "unknown";
+}
+
+/*
+ * Prepare the buffered reads of a file: evict the clean pages of the file
+ * from the page cache for a cold run, apply the file readahead advice and
+ * map the file to check the page cache residency of IO ranges with
+ * mincore(). The mapping is never accessed, so it does not populate the
+ * page cache.
+ */
+int zio_cache_init(struct zio_params *zio)
+{
+	size_t pgsz = sysconf(_SC_PAGESIZE);
+	int advice = -1;
+	int ret;
+
+	if (zio->evict) {
+		ret = posix_fadvise(zio->fd, 0, 0, POSIX_FADV_DONTNEED);
+		if (ret) {
+			fprintf(stderr, "Evict %s pages failed %d (%s)\n",
+				zio->path, ret, strerror(ret));
+			return -1;
+		}
+	}
+
+	if (zio->ra_hint == ZIO_RA_SEQ)
+		advice = POSIX_FADV_SEQUENTIAL;
+	else if (zio->ra_hint == ZIO_RA_RANDOM)
+		advice = POSIX_FADV_RANDOM;
+	if (advice >= 0) {
+		zio->nr_syscalls++;
+		ret = posix_fadvise(zio->fd, 0, 0, advice);
+		if (ret) {
+			fprintf(stderr, "fadvise %s %s failed %d (%s)\n",
+				zio->path, zio_ra_hint_name(zio->ra_hint),
+				ret, strerror(ret));
+			return -1;
+		}
+	}
+
+	if (!zio->cache_stats || !zio->fsize)
+		return 0;
+
+	zio->cache_map = mmap(NULL, zio->fsize, PROT_READ, MAP_SHARED,
+			      zio->fd, 0);
+	if (zio->cache_map == MAP_FAILED) {
+		zio->cache_map = NULL;
+		fprintf(stderr, "mmap %s failed %d (%s)\n",
+			zio->path, errno, strerror(errno));
+		return -1;
+	}
+
+	/* An unaligned IO range spans up to 2 more pages */
+	zio->cache_vec = malloc(zio->iosize / pgsz + 2);
+	if (!zio->cache_vec) {
+		fprintf(stderr, "No memory for page residency vector\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+void zio_cache_cleanup(struct zio_params *zio)
+{
+	if (zio->cache_map) {
+		munmap(zio->cache_map, zio->fsize);
+		zio->cache_map = NULL;
+	}
+	free(zio->cache_vec);
+	zio->cache_vec = NULL;
+}
+
+/*
+ * Count the pages of the IO range already in the page cache.
+ */
+static void zio_cache_lookup(struct zio_params *zio, loff_t ofst, size_t len)
+{
+	size_t pgsz = sysconf(_SC_PAGESIZE);
+	loff_t start, end;
+	size_t i, nr;
+
+	if (!zio->cache_map || ofst >= zio->fsize)
+		return;
+
+	start = ofst & ~((loff_t)pgsz - 1);
+	end = ofst + len;
+	if (end > zio->fsize)
+		end = zio->fsize;
+	end = (end + pgsz - 1) & ~((loff_t)pgsz - 1);
+	nr = (end - start) / pgsz;
+
+	if (mincore(zio->cache_map + start, end - start, zio->cache_vec))
+		return;
+
+	for (i = 0; i < nr; i++)
+		zio->nr_cache_hits += zio->cache_vec[i] & 1;
+	zio->nr_cache_lookups += nr;
+}
+
+/*
+ * Prepare a buffered read of len bytes at ofst: account the page cache
+ * hits of the range and, with the willneed and readahead hints, keep the
+ * readahead window hinted ahead of the read. The window is hinted again
+ * when less than half of it remains ahead of the read, and restarted at
+ * the read offset when the read is outside of it.
+ */
+int zio_cache_prep_read(struct zio_params *zio, loff_t ofst, size_t len)
+{
+	size_t ahead = zio->ra_window > len ? zio->ra_window : len;
+	loff_t from, to;
+	int ret;
+
+	zio_cache_lookup(zio, ofst, len);
+
+	if (zio->ra_hint != ZIO_RA_WILLNEED &&
+	    zio->ra_hint != ZIO_RA_READAHEAD)
+		return 0;
+
+	if (ofst < zio->ra_start || ofst >= zio->ra_end) {
+		from = ofst;
+		zio->ra_start = ofst;
+	} else if (zio->ra_end - ofst >= (loff_t)ahead / 2) {
+		return 0;
+	} else {
+		from = zio->ra_end;
+	}
+
+	to = ofst + ahead;
+	if (to > zio->fsize)
+		to = zio->fsize;
+	if (to <= from)
+		return 0;
+
+	zio->nr_syscalls++;
+	if (zio->ra_hint == ZIO_RA_WILLNEED) {
+		ret = posix_fadvise(zio->fd, from, to - from,
+				    POSIX_FADV_WILLNEED);
+	} else {
+		ret = 0;
+		if (readahead(zio->fd, from, to - from))
+			ret = errno;
+	}
+	if (ret) {
+		fprintf(stderr, "%s %s %lld B at %lld failed %d (%s)\n",
+			zio_ra_hint_name(zio->ra_hint), zio->path,
+			(long long)(to - from), (long long)from,
+			ret, strerror(ret));
+		return -1;
+	}
+
+	zio->ra_end = to;
+
+	return 0;
+}
+
+/*
+ * Page cache hit ratio of st in units of 0.01 %.
+ */
+unsigned long long zio_cache_hit_pct(struct zio_stats *st)
+{
+	if (!st->nr_cache_lookups)
+		return 0;
+
+	return st->nr_cache_hits * 10000ULL / st->nr_cache_lookups;
+}
+
+/*
+ * Print the page cache state before the reads, the readahead hint and the
+ * page cache hits of the reads.
+ */
+void zio_print_cache(struct zio_params *zio, struct zio_stats *st)
+{
+	unsigned long long pct = zio_cache_hit_pct(st);
+
+	printf("    Page cache: %s", zio->evict ? "cold" : "warm");
+	if (zio->cache_stats) {
+		printf(", readahead hint %s", zio_ra_hint_name(zio->ra_hint));
+		if (zio->ra_hint == ZIO_RA_WILLNEED ||
+		    zio->ra_hint == ZIO_RA_READAHEAD)
+			printf(", %zu B window", zio->ra_window);
+		printf(", %llu / %llu pages hit (%llu.%02llu %%)",
+		       st->nr_cache_hits, st->nr_cache_lookups,
+		       pct / 100, pct % 100);
+	}
+	printf("\n");
+}
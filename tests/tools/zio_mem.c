@@ -0,0 +1,125 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (C) 2026 Western Digital Corporation or its affiliates.
+ */
+
+#include "zio.h"
+
+#include <sys/mman.h>
+
+/* Huge page size used if it cannot be read from /proc/meminfo */
+#define ZIO_HUGEPAGE_SIZE	(2UL * 1024 * 1024)
+
+/*
+ * Get the default huge page size.
+ */
+static size_t zio_hugepage_size(void)
+{
+	size_t sz = ZIO_HUGEPAGE_SIZE;
+	unsigned long kb;
+	char line[128];
+	FILE *f;
+
+	f = fopen("/proc/meminfo", "r");
+	if (!f)
+		return sz;
+
+	while (fgets(line, sizeof(line), f)) {
+		if (sscanf(line, "Hugepagesize: %lu kB", &kb) == 1) {
+			sz = kb * 1024;
+			break;
+		}
+	}
+	fclose(f);
+
+	return sz;
+}
+
+const char *zio_mem_name(enum zio_mem mem)
+{
+	switch (mem) {
+	case ZIO_MEM_HUGETLB:
+		return "hugetlb";
+	case ZIO_MEM_THP:
+		return "thp";
+	case ZIO_MEM_MALLOC:
+	default:
+		return "malloc";
+	}
+}
+
+/*
+ * Allocate a pool of nr_slots IO buffers of slot_size bytes, rounded up to
+ * the page size, or reuse the pool if it is large enough. With hugetlb, the
+ * pool is a MAP_HUGETLB mapping, which needs huge pages reserved with
+ * /proc/sys/vm/nr_hugepages. With thp, the pool is aligned to the huge page
+ * size and madvised with MADV_HUGEPAGE. The pool pages are faulted in
+ * before any IO is done.
+ */
+int zio_pool_alloc(struct zio_pool *pool, enum zio_mem mem,
+		   size_t slot_size, unsigned int nr_slots)
+{
+	size_t pgsz = sysconf(_SC_PAGESIZE);
+	void *base;
+	int ret;
+
+	if (pool->base && pool->slot_size >= slot_size &&
+	    pool->nr_slots >= nr_slots)
+		return 0;
+	zio_pool_free(pool);
+
+	pool->mem = mem;
+	pool->slot_size = (slot_size + pgsz - 1) & ~(pgsz - 1);
+	pool->nr_slots = nr_slots;
+	pool->hpsz = zio_hugepage_size();
+	pool->size = pool->slot_size * nr_slots;
+	pool->size = (pool->size + pool->hpsz - 1) & ~(pool->hpsz - 1);
+
+	if (mem == ZIO_MEM_HUGETLB) {
+		base = mmap(NULL, pool->size, PROT_READ | PROT_WRITE,
+			    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB |
+			    MAP_POPULATE, -1, 0);
+		if (base == MAP_FAILED) {
+			fprintf(stderr,
+				"Allocate %zu B of huge pages failed %d (%s)\n",
+				pool->size, errno, strerror(errno));
+			fprintf(stderr,
+				"Check the number of huge pages reserved in /proc/sys/vm/nr_hugepages\n");
+			return -1;
+		}
+	} else {
+		ret = posix_memalign(&base, pool->hpsz, pool->size);
+		if (ret) {
+			fprintf(stderr,
+				"Allocate buffer pool failed %d (%s)\n",
+				ret, strerror(ret));
+			return -1;
+		}
+		if (madvise(base, pool->size, MADV_HUGEPAGE))
+			fprintf(stderr,
+				"madvise MADV_HUGEPAGE failed %d (%s)\n",
+				errno, strerror(errno));
+		memset(base, 0, pool->size);
+	}
+
+	pool->base = base;
+
+	return 0;
+}
+
+void *zio_pool_slot(struct zio_pool *pool, unsigned int idx)
+{
+	return pool->base + pool->slot_size * idx;
+}
+
+void zio_pool_free(struct zio_pool *pool)
+{
+	if (!pool->base)
+		return;
+
+	if (pool->mem == ZIO_MEM_HUGETLB)
+		munmap(pool->base, pool->size);
+	else
+		free(pool->base);
+	pool->base = NULL;
+}
@@ -0,0 +1,155 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (C) 2026 Western Digital Corporation or its affiliates.
+ */
+
+#include "zio.h"
+
+#include <stdint.h>
+#include <sys/mman.h>
+
+static const struct {
+	unsigned int flag;
+	int advice;
+	const char *name;
+} zio_madv[] = {
+	{ ZIO_MADV_SEQ,		MADV_SEQUENTIAL,	"sequential" },
+	{ ZIO_MADV_RANDOM,	MADV_RANDOM,		"random" },
+	{ ZIO_MADV_WILLNEED,	MADV_WILLNEED,		"willneed" },
+	{ ZIO_MADV_HUGEPAGE,	MADV_HUGEPAGE,		"hugepage" },
+};
+
+#define ZIO_NR_MADV	(sizeof(zio_madv) / sizeof(zio_madv[0]))
+
+/*
+ * Parse a madvise() hint name.
+ */
+int zio_parse_madv(const char *name, unsigned int *madv)
+{
+	unsigned int i;
+
+	for (i = 0; i < ZIO_NR_MADV; i++) {
+		if (strcmp(name, zio_madv[i].name) == 0) {
+			*madv |= zio_madv[i].flag;
+			return 0;
+		}
+	}
+
+	return -1;
+}
+
+void zio_print_madv(FILE *f, unsigned int madv, const char *sep)
+{
+	bool first = true;
+	unsigned int i;
+
+	for (i = 0; i < ZIO_NR_MADV; i++) {
+		if (!(madv & zio_madv[i].flag))
+			continue;
+		fprintf(f, "%s%s", first ? "" : sep, zio_madv[i].name);
+		first = false;
+	}
+}
+
+/*
+ * Sum the 64-bit words of a page range in place, without copying it.
+ */
+static uint64_t zio_mmap_sum(const void *addr, size_t len)
+{
+	const uint64_t *w = addr;
+	const unsigned char *b;
+	uint64_t sum = 0;
+	size_t i, n = len / sizeof(uint64_t);
+
+	for (i = 0; i < n; i++)
+		sum += w[i];
+
+	b = (const unsigned char *)(w + n);
+	for (i = 0; i < len % sizeof(uint64_t); i++)
+		sum += b[i];
+
+	return sum;
+}
+
+/*
+ * mmap read run: each IO accesses iosize bytes of the file mapping, either
+ * copying them to the IO buffer or summing them in place.
+ */
+int zio_run_mmap(struct zio_params *zio)
+{
+	struct zio *io = &zio->io[0];
+	struct iovec iov;
+	struct zio vio;
+	unsigned int i;
+	size_t len;
+	void *map;
+	int ret = 0;
+
+	if (!zio->fsize)
+		return 0;
+
+	map = mmap(NULL, zio->fsize, PROT_READ, MAP_SHARED, zio->fd, 0);
+	zio->nr_syscalls++;
+	if (map == MAP_FAILED) {
+		fprintf(stderr, "mmap %s failed %d (%s)\n",
+			zio->path, errno, strerror(errno));
+		return -1;
+	}
+
+	for (i = 0; i < ZIO_NR_MADV; i++) {
+		if (!(zio->madv & zio_madv[i].flag))
+			continue;
+		zio->nr_syscalls++;
+		if (madvise(map, zio->fsize, zio_madv[i].advice)) {
+			fprintf(stderr, "madvise %s %s failed %d (%s)\n",
+				zio->path, zio_madv[i].name,
+				errno, strerror(errno));
+			ret = -1;
+			goto out;
+		}
+	}
+
+	while (!zio_done(zio)) {
+		zio_next_ofst(zio);
+		if (zio->ioofst >= zio->fsize)
+			break;
+		len = zio->iosize;
+		if (zio->ioofst + (loff_t)len > zio->fsize)
+			len = zio->fsize - zio->ioofst;
+
+		if (zio->rate_ns) {
+			io->issue_ns = zio_rate_next(zio);
+			zio_wait_until(io->issue_ns);
+		}
+		zio_io_issue(zio, io, zio_nsec());
+		if (zio->mmap_copy)
+			memcpy(io->buf, map + zio->ioofst, len);
+		else
+			zio->mmap_sum += zio_mmap_sum(map + zio->ioofst, len);
+		zio_io_done(zio, io, zio_nsec());
+
+		if (zio->verify) {
+			if (zio->mmap_copy) {
+				zio_verify_check(zio, io, zio->ioofst, len);
+			} else {
+				iov.iov_base = map + zio->ioofst;
+				iov.iov_len = len;
+				vio.iov = &iov;
+				zio_verify_check(zio, &vio, zio->ioofst, len);
+			}
+		}
+
+		zio_vprintf(zio, "%05u: MMAP %s %zu B at %ld done\n",
+			    zio->nr_ios,
+			    zio->mmap_copy ? "COPY" : "SUM",
+			    len, zio->ioofst);
+
+		zio->nr_ios++;
+		zio->ioofst += len;
+	}
+
+out:
+	munmap(map, zio->fsize);
+
+	return ret;
+}
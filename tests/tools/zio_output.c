@@ -0,0 +1,453 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (C) 2026 Western Digital Corporation or its affiliates.
+ */
+
+#include "zio.h"
+
+/*
+ * Structured result output, for loading run results in a database without
+ * parsing the human readable output.
+ */
+
+struct zio_flag_name {
+	int flag;
+	const char *name;
+};
+
+static const struct zio_flag_name zio_fflag_names[] = {
+	{ O_DIRECT,	"direct" },
+	{ O_APPEND,	"append" },
+	{ O_NDELAY,	"ndelay" },
+	{ O_SYNC,	"sync" },
+	{ O_DSYNC,	"dsync" },
+	{ O_TRUNC,	"trunc" },
+	{ 0,		NULL },
+};
+
+static const struct zio_flag_name zio_ioflag_names[] = {
+	{ RWF_NOWAIT,	"nowait" },
+	{ RWF_HIPRI,	"hipri" },
+	{ RWF_APPEND,	"append" },
+	{ RWF_DSYNC,	"dsync" },
+	{ 0,		NULL },
+};
+
+static bool zio_has_flag(int flags, int flag)
+{
+	return (flags & flag) == flag;
+}
+
+static const char *zio_rand_name(enum zio_rand rand)
+{
+	switch (rand) {
+	case ZIO_RAND_UNIFORM:
+		return "uniform";
+	case ZIO_RAND_ZIPF:
+		return "zipf";
+	case ZIO_RAND_HOTSPOT:
+		return "hotspot";
+	case ZIO_RAND_NONE:
+	default:
+		return "none";
+	}
+}
+
+/*
+ * Print flag names separated with sep. Flags with all their bits part of a
+ * flag already printed (O_DSYNC with O_SYNC) are skipped.
+ */
+static void zio_print_flags(FILE *f, const struct zio_flag_name *names,
+			    int flags, const char *sep, const char *quote)
+{
+	int printed = 0;
+
+	for (; names->name; names++) {
+		if (!zio_has_flag(flags, names->flag) ||
+		    !(names->flag & ~printed))
+			continue;
+		fprintf(f, "%s%s%s%s", printed ? sep : "",
+			quote, names->name, quote);
+		printed |= names->flag;
+	}
+}
+
+static void zio_json_string(FILE *f, const char *s)
+{
+	fputc('"', f);
+	for (; *s; s++) {
+		if (*s == '"' || *s == '\\')
+			fprintf(f, "\\%c", *s);
+		else if ((unsigned char)*s < 0x20)
+			fprintf(f, "\\u%04x", *s);
+		else
+			fputc(*s, f);
+	}
+	fputc('"', f);
+}
+
+static void zio_json_params(FILE *f, struct zio_jobs *jobs,
+			    struct zio_result *res)
+{
+	struct zio_params *zio = jobs->zio;
+	unsigned int i;
+
+	fprintf(f, "  \"params\": {\n");
+	fprintf(f, "    \"files\": [");
+	for (i = 0; i < jobs->nr_files; i++) {
+		fprintf(f, "%s", i ? ", " : "");
+		zio_json_string(f, jobs->files[i]);
+	}
+	fprintf(f, "],\n");
+	fprintf(f, "    \"rw\": \"%s\",\n", zio->read ? "read" : "write");
+	fprintf(f, "    \"engine\": \"%s\",\n", zio_engine_name(zio->engine));
+	fprintf(f, "    \"fflags\": [");
+	zio_print_flags(f, zio_fflag_names, zio->fflags, ", ", "\"");
+	fprintf(f, "],\n");
+	fprintf(f, "    \"ioflags\": [");
+	zio_print_flags(f, zio_ioflag_names, zio->ioflags, ", ", "\"");
+	fprintf(f, "],\n");
+	fprintf(f, "    \"iosize\": %zu,\n", zio->iosize);
+	fprintf(f, "    \"iodepth\": %u,\n", zio->iodepth);
+	fprintf(f, "    \"iovec\": %s,\n", zio->iovec ? "true" : "false");
+	fprintf(f, "    \"batch_min\": %u,\n", zio->batch_min);
+	fprintf(f, "    \"batch_max\": %u,\n", zio->batch_max);
+	fprintf(f, "    \"ofst\": %lld,\n", (long long)zio->ioofst);
+	fprintf(f, "    \"nio\": %llu,\n", (unsigned long long)zio->ionum);
+	fprintf(f, "    \"jobs\": %u,\n", jobs->nr_jobs);
+	fprintf(f, "    \"shared_file\": %s,\n",
+		jobs->shared ? "true" : "false");
+	fprintf(f, "    \"poll\": \"%s\",\n", zio_poll_name(zio->poll));
+	if (zio->engine == ZIO_ENGINE_MMAP) {
+		fprintf(f, "    \"mmap_read\": \"%s\",\n",
+			zio->mmap_copy ? "copy" : "checksum");
+		fprintf(f, "    \"madvise\": [");
+		if (zio->madv) {
+			fprintf(f, "\"");
+			zio_print_madv(f, zio->madv, "\", \"");
+			fprintf(f, "\"");
+		}
+		fprintf(f, "],\n");
+	}
+	fprintf(f, "    \"evict\": %s,\n", zio->evict ? "true" : "false");
+	if (zio->cache_stats)
+		fprintf(f, "    \"ra_hint\": \"%s\",\n",
+			zio_ra_hint_name(zio->ra_hint));
+	if (jobs->ra_min)
+		fprintf(f,
+			"    \"ra_sweep_min\": %zu,\n"
+			"    \"ra_sweep_max\": %zu,\n",
+			jobs->ra_min, jobs->ra_max);
+	else if (zio->cache_stats)
+		fprintf(f, "    \"ra_window\": %zu,\n", zio->ra_window);
+	fprintf(f, "    \"sqpoll\": %s,\n", zio->sqpoll ? "true" : "false");
+	fprintf(f, "    \"fixed_files\": %s,\n",
+		zio->fixed_files ? "true" : "false");
+	fprintf(f, "    \"fixed_bufs\": %s,\n",
+		zio->fixed_bufs ? "true" : "false");
+	fprintf(f, "    \"mem\": \"%s\",\n", zio_mem_name(zio->mem));
+	fprintf(f, "    \"cpus\": ");
+	zio_json_string(f, jobs->cpus_arg ? jobs->cpus_arg : "");
+	fprintf(f, ",\n");
+	fprintf(f, "    \"numa_node\": %d,\n", jobs->numa_node);
+	fprintf(f, "    \"rand\": \"%s\",\n", zio_rand_name(zio->rand));
+	if (zio->rand) {
+		fprintf(f, "    \"rand_seed\": %llu,\n", zio->rand_seed);
+		fprintf(f, "    \"align\": %zu,\n", zio->rand_align);
+		fprintf(f, "    \"wset\": %lld,\n", (long long)zio->rand_wset);
+		if (zio->rand == ZIO_RAND_ZIPF)
+			fprintf(f, "    \"zipf_theta\": %.2f,\n",
+				zio->zipf_theta);
+		if (zio->rand == ZIO_RAND_HOTSPOT)
+			fprintf(f,
+				"    \"hot_pct\": %u,\n"
+				"    \"hot_access_pct\": %u,\n",
+				zio->hot_pct, zio->hot_access_pct);
+	}
+	fprintf(f, "    \"rate_iops\": %.0f,\n", res->rate_iops);
+	fprintf(f, "    \"runtime\": %.3f,\n", res->runtime);
+	fprintf(f, "    \"interval\": %.3f,\n", jobs->interval_ns / 1e9);
+	fprintf(f, "    \"wrap\": %s,\n", zio->wrap ? "true" : "false");
+	fprintf(f, "    \"verify\": %s\n", zio->verify ? "true" : "false");
+	fprintf(f, "  },\n");
+}
+
+static void zio_json_lat(FILE *f, struct zio_hist *h, const char *indent)
+{
+	fprintf(f, "%s\"lat_ns\": {\n", indent);
+	fprintf(f, "%s  \"min\": %llu,\n", indent, h->nr ? h->min : 0);
+	fprintf(f, "%s  \"mean\": %llu,\n", indent,
+		h->nr ? h->sum / h->nr : 0);
+	fprintf(f, "%s  \"max\": %llu,\n", indent, h->nr ? h->max : 0);
+	fprintf(f, "%s  \"p50\": %llu,\n", indent, zio_hist_pct(h, 50));
+	fprintf(f, "%s  \"p90\": %llu,\n", indent, zio_hist_pct(h, 90));
+	fprintf(f, "%s  \"p99\": %llu,\n", indent, zio_hist_pct(h, 99));
+	fprintf(f, "%s  \"p99.9\": %llu,\n", indent, zio_hist_pct(h, 99.9));
+	fprintf(f, "%s  \"p99.99\": %llu\n", indent, zio_hist_pct(h, 99.99));
+	fprintf(f, "%s}", indent);
+}
+
+static void zio_json_totals(FILE *f, struct zio_jobs *jobs,
+			    struct zio_result *res)
+{
+	struct zio_stats *st = &res->st;
+
+	fprintf(f, "  \"totals\": {\n");
+	fprintf(f, "    \"elapsed_us\": %llu,\n", res->elapsed);
+	fprintf(f, "    \"files\": %u,\n", st->nr_files);
+	fprintf(f, "    \"ios\": %llu,\n", st->nr_ios);
+	fprintf(f, "    \"bytes\": %llu,\n", st->nr_bytes);
+	fprintf(f, "    \"iops\": %llu,\n", res->iops);
+	fprintf(f, "    \"bw_bytes\": %llu,\n", res->bw);
+	fprintf(f, "    \"cpu_usr_us\": %llu,\n", res->cpu_usr);
+	fprintf(f, "    \"cpu_sys_us\": %llu,\n", res->cpu_sys);
+	fprintf(f, "    \"syscalls\": %llu,\n", st->nr_syscalls);
+	fprintf(f, "    \"minflt\": %llu,\n", res->minflt);
+	fprintf(f, "    \"majflt\": %llu,\n", res->majflt);
+	if (res->rate_iops) {
+		fprintf(f, "    \"rate_lag_mean_ns\": %llu,\n",
+			st->nr_ios ? st->rate_lag_sum / st->nr_ios : 0);
+		fprintf(f, "    \"rate_lag_max_ns\": %llu,\n",
+			st->rate_lag_max);
+	}
+	if (jobs->zio->verify && jobs->zio->read) {
+		fprintf(f, "    \"verified\": %llu,\n", st->nr_verified);
+		fprintf(f, "    \"verify_errors\": %llu,\n",
+			st->nr_verify_errors);
+	}
+	if (jobs->zio->cache_stats) {
+		fprintf(f, "    \"cache_hits\": %llu,\n", st->nr_cache_hits);
+		fprintf(f, "    \"cache_lookups\": %llu,\n",
+			st->nr_cache_lookups);
+	}
+	zio_json_lat(f, &st->lat, "    ");
+	fprintf(f, "\n  },\n");
+}
+
+static void zio_json_place(FILE *f, struct zio_place *place)
+{
+	unsigned int i;
+
+	fprintf(f, "      \"cpu\": %d,\n", place->cpu);
+	fprintf(f, "      \"hw_queue\": %d,\n", place->hwq);
+	fprintf(f, "      \"irqs\": [");
+	for (i = 0; i < place->nr_irqs; i++) {
+		fprintf(f, "%s{ \"irq\": %d, \"cpus\": ",
+			i ? ", " : "", place->irqs[i].irq);
+		zio_json_string(f, place->irqs[i].cpus);
+		fprintf(f, " }");
+	}
+	fprintf(f, "],\n");
+}
+
+static void zio_json_jobs(FILE *f, struct zio_jobs *jobs)
+{
+	struct zio_job *job;
+	unsigned int i;
+
+	fprintf(f, "  \"jobs\": [\n");
+	for (i = 0; i < jobs->nr_jobs; i++) {
+		job = &jobs->job[i];
+		fprintf(f, "    {\n");
+		fprintf(f, "      \"id\": %u,\n", job->id);
+		fprintf(f, "      \"elapsed_us\": %llu,\n", job->elapsed);
+		fprintf(f, "      \"files\": %u,\n", job->stats.nr_files);
+		fprintf(f, "      \"ios\": %llu,\n", job->stats.nr_ios);
+		fprintf(f, "      \"bytes\": %llu,\n", job->stats.nr_bytes);
+		zio_json_place(f, &job->place);
+		zio_json_lat(f, &job->stats.lat, "      ");
+		fprintf(f, "\n    }%s\n", i + 1 < jobs->nr_jobs ? "," : "");
+	}
+	fprintf(f, "  ],\n");
+}
+
+static void zio_json_intervals(FILE *f, struct zio_jobs *jobs)
+{
+	struct zio_sample *s;
+	unsigned int i;
+
+	fprintf(f, "  \"intervals\": [\n");
+	for (i = 0; i < jobs->nr_samples; i++) {
+		s = &jobs->samples[i];
+		fprintf(f,
+			"    { \"time_ns\": %llu, \"duration_ns\": %llu, "
+			"\"ios\": %llu, \"bytes\": %llu, \"lat_p50_ns\": %llu, "
+			"\"lat_p99_ns\": %llu, \"lat_max_ns\": %llu }%s\n",
+			s->time, s->duration, s->nr_ios, s->nr_bytes,
+			s->p50, s->p99, s->max,
+			i + 1 < jobs->nr_samples ? "," : "");
+	}
+	fprintf(f, "  ]\n");
+}
+
+static void zio_json_device(FILE *f, struct zio_jobs *jobs)
+{
+	fprintf(f, "  \"device\": { \"name\": ");
+	zio_json_string(f, jobs->dev.name);
+	fprintf(f, ", \"numa_node\": %d },\n", jobs->dev.numa_node);
+}
+
+/*
+ * Print the run parameters, totals, per-job results and interval samples
+ * as a JSON object.
+ */
+void zio_output_json(struct zio_jobs *jobs, struct zio_result *res)
+{
+	FILE *f = stdout;
+
+	fprintf(f, "{\n");
+	zio_json_params(f, jobs, res);
+	zio_json_device(f, jobs);
+	zio_json_totals(f, jobs, res);
+	zio_json_jobs(f, jobs);
+	zio_json_intervals(f, jobs);
+	fprintf(f, "}\n");
+}
+
+/*
+ * Print the run parameters and the results of each pass of a readahead
+ * window sweep as a JSON object.
+ */
+void zio_output_sweep_json(struct zio_jobs *jobs, struct zio_ra_pass *pass,
+			   unsigned int nr_passes)
+{
+	struct zio_stats *st;
+	FILE *f = stdout;
+	unsigned int i;
+
+	fprintf(f, "{\n");
+	zio_json_params(f, jobs, &pass[0].res);
+	zio_json_device(f, jobs);
+	fprintf(f, "  \"passes\": [\n");
+	for (i = 0; i < nr_passes; i++) {
+		st = &pass[i].res.st;
+		fprintf(f, "    {\n");
+		fprintf(f, "      \"ra_window\": %zu,\n", pass[i].window);
+		fprintf(f, "      \"cache\": \"%s\",\n",
+			pass[i].cold ? "cold" : "warm");
+		fprintf(f, "      \"elapsed_us\": %llu,\n",
+			pass[i].res.elapsed);
+		fprintf(f, "      \"ios\": %llu,\n", st->nr_ios);
+		fprintf(f, "      \"bytes\": %llu,\n", st->nr_bytes);
+		fprintf(f, "      \"iops\": %llu,\n", pass[i].res.iops);
+		fprintf(f, "      \"bw_bytes\": %llu,\n", pass[i].res.bw);
+		fprintf(f, "      \"syscalls\": %llu,\n", st->nr_syscalls);
+		fprintf(f, "      \"cache_hits\": %llu,\n", st->nr_cache_hits);
+		fprintf(f, "      \"cache_lookups\": %llu,\n",
+			st->nr_cache_lookups);
+		zio_json_lat(f, &st->lat, "      ");
+		fprintf(f, "\n    }%s\n", i + 1 < nr_passes ? "," : "");
+	}
+	fprintf(f, "  ]\n");
+	fprintf(f, "}\n");
+}
+
+/*
+ * Print one CSV row with the run parameters columns. Flags are separated
+ * with '|' and paths are omitted so that no field needs quoting.
+ */
+static void zio_csv_params(FILE *f, struct zio_jobs *jobs)
+{
+	struct zio_params *zio = jobs->zio;
+
+	fprintf(f, "%s,%s,%s,", zio->read ? "read" : "write",
+		zio_engine_name(zio->engine), zio_poll_name(zio->poll));
+	zio_print_flags(f, zio_fflag_names, zio->fflags, "|", "");
+	fprintf(f, ",");
+	zio_print_flags(f, zio_ioflag_names, zio->ioflags, "|", "");
+	fprintf(f, ",%zu,%u,%u,%u,%s,", zio->iosize, zio->iodepth,
+		jobs->nr_jobs, jobs->nr_files, zio_rand_name(zio->rand));
+}
+
+static void zio_csv_header(FILE *f)
+{
+	fprintf(f, "type,rw,engine,poll,fflags,ioflags,iosize,iodepth,jobs,files,"
+		"rand,time_ns,duration_ns,ios,bytes,iops,bw_bytes,"
+		"cpu_usr_us,cpu_sys_us,syscalls,lat_min_ns,lat_mean_ns,"
+		"lat_p50_ns,lat_p90_ns,lat_p99_ns,lat_p99.9_ns,lat_p99.99_ns,"
+		"lat_max_ns,evict,ra_hint,ra_window,cache_hits,cache_lookups\n");
+}
+
+/*
+ * Print a row with the totals of a run. The page cache columns are empty
+ * unless page cache hits are counted.
+ */
+static void zio_csv_total(FILE *f, struct zio_jobs *jobs,
+			  struct zio_result *res, const char *type)
+{
+	struct zio_params *zio = jobs->zio;
+	struct zio_stats *st = &res->st;
+	struct zio_hist *h = &st->lat;
+
+	fprintf(f, "%s,", type);
+	zio_csv_params(f, jobs);
+	fprintf(f, "%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,",
+		res->elapsed * 1000, res->elapsed * 1000,
+		st->nr_ios, st->nr_bytes, res->iops, res->bw,
+		res->cpu_usr, res->cpu_sys, st->nr_syscalls);
+	fprintf(f, "%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,",
+		h->nr ? h->min : 0, h->nr ? h->sum / h->nr : 0,
+		zio_hist_pct(h, 50), zio_hist_pct(h, 90),
+		zio_hist_pct(h, 99), zio_hist_pct(h, 99.9),
+		zio_hist_pct(h, 99.99), h->nr ? h->max : 0);
+	fprintf(f, "%s,", zio->evict ? "true" : "false");
+	if (zio->cache_stats)
+		fprintf(f, "%s,%zu,%llu,%llu\n",
+			zio_ra_hint_name(zio->ra_hint), zio->ra_window,
+			st->nr_cache_hits, st->nr_cache_lookups);
+	else
+		fprintf(f, ",,,\n");
+}
+
+/*
+ * Print a header line followed by one "total" row and one "interval" row
+ * per interval sample. Interval rows only have the p50, p99 and max
+ * latencies.
+ */
+void zio_output_csv(struct zio_jobs *jobs, struct zio_result *res)
+{
+	unsigned long long iops, bw;
+	struct zio_sample *s;
+	FILE *f = stdout;
+	unsigned int i;
+
+	zio_csv_header(f);
+	zio_csv_total(f, jobs, res, "total");
+
+	for (i = 0; i < jobs->nr_samples; i++) {
+		s = &jobs->samples[i];
+		iops = 0;
+		bw = 0;
+		if (s->duration) {
+			iops = s->nr_ios * 1000000000.0 / s->duration;
+			bw = s->nr_bytes * 1000000000.0 / s->duration;
+		}
+		fprintf(f, "interval,");
+		zio_csv_params(f, jobs);
+		fprintf(f, "%llu,%llu,%llu,%llu,%llu,%llu,,,,",
+			s->time, s->duration, s->nr_ios, s->nr_bytes,
+			iops, bw);
+		fprintf(f, ",,%llu,,%llu,,,%llu,,,,,\n",
+			s->p50, s->p99, s->max);
+	}
+}
+
+/*
+ * Print a header line followed by one "cold" and one "warm" row per
+ * readahead window of a sweep.
+ */
+void zio_output_sweep_csv(struct zio_jobs *jobs, struct zio_ra_pass *pass,
+			  unsigned int nr_passes)
+{
+	struct zio_params *zio = jobs->zio;
+	FILE *f = stdout;
+	unsigned int i;
+
+	zio_csv_header(f);
+	for (i = 0; i < nr_passes; i++) {
+		zio->ra_window = pass[i].window;
+		zio->evict = pass[i].cold;
+		zio_csv_total(f, jobs, &pass[i].res,
+			      pass[i].cold ? "cold" : "warm");
+	}
+}
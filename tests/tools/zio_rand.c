@@ -0,0 +1,191 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (C) 2026 Western Digital Corporation or its affiliates.
+ */
+
+#include "zio.h"
+
+#include <math.h>
+
+/* Large prime used to scatter the ranks of zipf distributed blocks */
+#define ZIO_RAND_SCATTER	2654435761ULL
+
+static unsigned long long zio_rand_mix(unsigned long long x)
+{
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+
+	return x ^ (x >> 31);
+}
+
+/*
+ * xorshift64* generator.
+ */
+static unsigned long long zio_rand_next(struct zio_params *zio)
+{
+	unsigned long long x = zio->rand_state;
+
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	zio->rand_state = x;
+
+	return x * 0x2545f4914f6cdd1dULL;
+}
+
+/*
+ * Uniform value in [0, 1).
+ */
+static double zio_rand_unit(struct zio_params *zio)
+{
+	return (zio_rand_next(zio) >> 11) * (1.0 / (1ULL << 53));
+}
+
+/*
+ * Uniform value in [0, n).
+ */
+static unsigned long long zio_rand_range(struct zio_params *zio,
+					 unsigned long long n)
+{
+	return (unsigned __int128)zio_rand_next(zio) * n >> 64;
+}
+
+/*
+ * Zipf distributed block rank, using the method of Gray et al.,
+ * "Quickly generating billion-record synthetic databases".
+ */
+static unsigned long long zio_rand_zipf(struct zio_params *zio)
+{
+	unsigned long long n = zio->rand_nr_blks;
+	double u = zio_rand_unit(zio);
+	double uz = u * zio->zipf_zetan;
+	unsigned long long rank;
+
+	if (uz < 1.0)
+		return 0;
+	if (uz < 1.0 + pow(0.5, zio->zipf_theta))
+		return 1;
+
+	rank = n * pow(zio->zipf_eta * u - zio->zipf_eta + 1.0,
+		       zio->zipf_alpha);
+	if (rank >= n)
+		rank = n - 1;
+
+	return rank;
+}
+
+/*
+ * Get the offset of the next random IO. Zipf ranks are scattered over the
+ * file so that the most accessed blocks are not all at the file start.
+ * With a hot spot, hot_access_pct % of the IOs go to the first hot_pct % of
+ * the file.
+ */
+loff_t zio_rand_ofst(struct zio_params *zio)
+{
+	unsigned long long n = zio->rand_nr_blks, nr_hot, blk;
+
+	switch (zio->rand) {
+	case ZIO_RAND_ZIPF:
+		blk = zio_rand_zipf(zio);
+		if (n % ZIO_RAND_SCATTER)
+			blk = (unsigned __int128)blk * ZIO_RAND_SCATTER % n;
+		break;
+	case ZIO_RAND_HOTSPOT:
+		nr_hot = n * zio->hot_pct / 100;
+		if (!nr_hot)
+			nr_hot = 1;
+		if (nr_hot < n &&
+		    zio_rand_unit(zio) * 100 >= zio->hot_access_pct)
+			blk = nr_hot + zio_rand_range(zio, n - nr_hot);
+		else
+			blk = zio_rand_range(zio, nr_hot);
+		break;
+	case ZIO_RAND_UNIFORM:
+	default:
+		blk = zio_rand_range(zio, n);
+		break;
+	}
+
+	return blk * zio->rand_align;
+}
+
+/*
+ * Get zeta(n) = sum(1 / i^theta) for i in [1, n]. The value is cached in
+ * the job and a cached value for a smaller n is extended, so that files of
+ * the same size or growing sizes do not compute the whole sum again.
+ */
+static double zio_rand_zeta(struct zio_params *zio, unsigned long long n)
+{
+	struct zio_zeta *zeta = zio->zeta;
+	unsigned long long i = 1;
+	double zetan = 0;
+
+	if (zeta && zeta->n == n)
+		return zeta->zetan;
+
+	if (zeta && zeta->n && zeta->n < n) {
+		i = zeta->n + 1;
+		zetan = zeta->zetan;
+	}
+	for (; i <= n; i++)
+		zetan += 1.0 / pow(i, zio->zipf_theta);
+
+	if (zeta) {
+		zeta->n = n;
+		zeta->zetan = zetan;
+	}
+
+	return zetan;
+}
+
+/*
+ * Prepare random IOs for a file: IOs are aligned to rand_align (default:
+ * file block size) and fall within the first rand_wset bytes of the file
+ * (default: size). Without a number of IOs specified, do as many IOs as
+ * needed to access the working set size.
+ */
+int zio_rand_init(struct zio_params *zio, loff_t size)
+{
+	double zeta2;
+
+	if (zio->rand_wset) {
+		if (zio->rand_wset > size) {
+			fprintf(stderr,
+				"%s: working set larger than the file size\n",
+				zio->path);
+			return -1;
+		}
+		size = zio->rand_wset;
+	}
+
+	if (!zio->rand_align)
+		zio->rand_align = zio->blksize;
+
+	if (size < (loff_t)zio->iosize) {
+		fprintf(stderr, "%s: file too small for random IOs\n",
+			zio->path);
+		return -1;
+	}
+
+	zio->rand_nr_blks = (size - zio->iosize) / zio->rand_align + 1;
+	zio->rand_state = zio_rand_mix(zio->rand_seed ^
+				       zio_rand_mix(zio->ino ^
+						    zio_rand_mix(zio->job)));
+	if (!zio->rand_state)
+		zio->rand_state = 1;
+
+	if (!zio->ionum)
+		zio->ionum = size / zio->iosize;
+
+	if (zio->rand != ZIO_RAND_ZIPF)
+		return 0;
+
+	zio->zipf_zetan = zio_rand_zeta(zio, zio->rand_nr_blks);
+	zeta2 = 1.0 + 1.0 / pow(2, zio->zipf_theta);
+	zio->zipf_alpha = 1.0 / (1.0 - zio->zipf_theta);
+	zio->zipf_eta = (1.0 - pow(2.0 / zio->rand_nr_blks,
+				   1.0 - zio->zipf_theta)) /
+		(1.0 - zeta2 / zio->zipf_zetan);
+
+	return 0;
+}
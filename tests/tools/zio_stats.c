@@ -0,0 +1,293 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (C) 2026 Western Digital Corporation or its affiliates.
+ */
+
+#include "zio.h"
+
+/*
+ * Log-linear latency histogram: values below 2 * ZIO_HIST_SUB nanoseconds
+ * have their own bucket. Above that, each power of 2 range is split into
+ * ZIO_HIST_SUB buckets, giving a relative error below 1 / ZIO_HIST_SUB.
+ */
+static unsigned int zio_hist_idx(unsigned long long v)
+{
+	unsigned int shift;
+
+	if (v < 2 * ZIO_HIST_SUB)
+		return v;
+
+	shift = 63 - __builtin_clzll(v) - ZIO_HIST_SUB_BITS;
+
+	return shift * ZIO_HIST_SUB + (v >> shift);
+}
+
+/*
+ * Lowest value of a histogram bucket.
+ */
+static unsigned long long zio_hist_bucket_start(unsigned int idx)
+{
+	unsigned int shift;
+
+	if (idx < 2 * ZIO_HIST_SUB)
+		return idx;
+
+	shift = idx / ZIO_HIST_SUB - 1;
+
+	return (unsigned long long)(idx - shift * ZIO_HIST_SUB) << shift;
+}
+
+/*
+ * Number of values of a histogram bucket.
+ */
+static unsigned long long zio_hist_bucket_len(unsigned int idx)
+{
+	if (idx < 2 * ZIO_HIST_SUB)
+		return 1;
+
+	return 1ULL << (idx / ZIO_HIST_SUB - 1);
+}
+
+void zio_hist_init(struct zio_hist *h)
+{
+	memset(h, 0, sizeof(*h));
+	h->min = ULLONG_MAX;
+}
+
+void zio_hist_add(struct zio_hist *h, unsigned long long v)
+{
+	h->buckets[zio_hist_idx(v)]++;
+	h->nr++;
+	h->sum += v;
+	if (v < h->min)
+		h->min = v;
+	if (v > h->max)
+		h->max = v;
+}
+
+void zio_hist_merge(struct zio_hist *h, struct zio_hist *from)
+{
+	unsigned int i;
+
+	if (!from->nr)
+		return;
+
+	for (i = 0; i < ZIO_HIST_NR_BUCKETS; i++)
+		h->buckets[i] += from->buckets[i];
+	h->nr += from->nr;
+	h->sum += from->sum;
+	if (from->min < h->min)
+		h->min = from->min;
+	if (from->max > h->max)
+		h->max = from->max;
+}
+
+/*
+ * Remove from h the values of from, an earlier state of h. The minimum and
+ * maximum become the bounds of the lowest and highest non-empty buckets.
+ */
+void zio_hist_sub(struct zio_hist *h, struct zio_hist *from)
+{
+	unsigned int i, first = ZIO_HIST_NR_BUCKETS, last = 0;
+
+	for (i = 0; i < ZIO_HIST_NR_BUCKETS; i++) {
+		h->buckets[i] -= from->buckets[i];
+		if (!h->buckets[i])
+			continue;
+		if (first == ZIO_HIST_NR_BUCKETS)
+			first = i;
+		last = i;
+	}
+	h->nr -= from->nr;
+	h->sum -= from->sum;
+
+	if (!h->nr) {
+		h->min = ULLONG_MAX;
+		h->max = 0;
+		return;
+	}
+
+	if (zio_hist_bucket_start(first) > h->min)
+		h->min = zio_hist_bucket_start(first);
+	if (zio_hist_bucket_start(last) + zio_hist_bucket_len(last) - 1 <
+	    h->max)
+		h->max = zio_hist_bucket_start(last) +
+			zio_hist_bucket_len(last) - 1;
+}
+
+/*
+ * Get the value below which pct percent of the values fall, using the
+ * middle of the bucket containing that value.
+ */
+unsigned long long zio_hist_pct(struct zio_hist *h, double pct)
+{
+	unsigned long long target, cnt = 0, v;
+	unsigned int i;
+
+	if (!h->nr)
+		return 0;
+
+	target = (unsigned long long)(pct * h->nr / 100.0 + 0.5);
+	if (!target)
+		target = 1;
+
+	for (i = 0; i < ZIO_HIST_NR_BUCKETS; i++) {
+		cnt += h->buckets[i];
+		if (cnt >= target)
+			break;
+	}
+
+	v = zio_hist_bucket_start(i) + zio_hist_bucket_len(i) / 2;
+	if (v < h->min)
+		return h->min;
+	if (v > h->max)
+		return h->max;
+
+	return v;
+}
+
+#define zio_ns_to_us(ns)	((ns) / 1000), ((ns) % 1000)
+
+/*
+ * Print latency statistics.
+ */
+void zio_hist_print(FILE *f, struct zio_hist *h, const char *indent)
+{
+	if (!h->nr)
+		return;
+
+	fprintf(f, "%sLatency (us): min %llu.%03llu, mean %llu.%03llu, "
+		"max %llu.%03llu\n",
+		indent,
+		zio_ns_to_us(h->min),
+		zio_ns_to_us(h->sum / h->nr),
+		zio_ns_to_us(h->max));
+	fprintf(f, "%s  p50 %llu.%03llu, p90 %llu.%03llu, p99 %llu.%03llu, "
+		"p99.9 %llu.%03llu, p99.99 %llu.%03llu\n",
+		indent,
+		zio_ns_to_us(zio_hist_pct(h, 50)),
+		zio_ns_to_us(zio_hist_pct(h, 90)),
+		zio_ns_to_us(zio_hist_pct(h, 99)),
+		zio_ns_to_us(zio_hist_pct(h, 99.9)),
+		zio_ns_to_us(zio_hist_pct(h, 99.99)));
+}
+
+/*
+ * Save the non-empty buckets of a histogram to a file, one bucket per
+ * line, so that the histograms of different runs can be merged by adding
+ * the counts of buckets with the same range.
+ */
+int zio_hist_dump(struct zio_hist *h, const char *path)
+{
+	unsigned int i;
+	FILE *f;
+
+	f = fopen(path, "w");
+	if (!f) {
+		fprintf(stderr, "Open %s failed %d (%s)\n",
+			path, errno, strerror(errno));
+		return -1;
+	}
+
+	fprintf(f, "# Latency histogram: %llu IOs\n", h->nr);
+	fprintf(f, "# <start ns> <end ns> <count>\n");
+	for (i = 0; i < ZIO_HIST_NR_BUCKETS; i++) {
+		if (!h->buckets[i])
+			continue;
+		fprintf(f, "%llu %llu %llu\n",
+			zio_hist_bucket_start(i),
+			zio_hist_bucket_start(i) + zio_hist_bucket_len(i) - 1,
+			h->buckets[i]);
+	}
+
+	if (fclose(f)) {
+		fprintf(stderr, "Write %s failed %d (%s)\n",
+			path, errno, strerror(errno));
+		return -1;
+	}
+
+	return 0;
+}
+
+void zio_stats_init(struct zio_stats *st)
+{
+	memset(st, 0, sizeof(*st));
+	zio_hist_init(&st->lat);
+}
+
+/*
+ * Account the IOs of a file run.
+ */
+void zio_stats_add(struct zio_stats *st, struct zio_params *zio)
+{
+	st->nr_files++;
+	st->nr_ios += zio->nr_ios;
+	st->nr_bytes += (unsigned long long)zio->nr_ios * zio->iosize;
+	st->nr_syscalls += zio->nr_syscalls;
+	st->nr_verified += zio->nr_verified;
+	st->nr_verify_errors += zio->nr_verify_errors;
+	st->rate_lag_sum += zio->rate_lag_sum;
+	if (zio->rate_lag_max > st->rate_lag_max)
+		st->rate_lag_max = zio->rate_lag_max;
+	st->mmap_sum += zio->mmap_sum;
+	st->nr_cache_hits += zio->nr_cache_hits;
+	st->nr_cache_lookups += zio->nr_cache_lookups;
+	zio_hist_merge(&st->lat, &zio->lat);
+}
+
+void zio_stats_merge(struct zio_stats *st, struct zio_stats *from)
+{
+	st->nr_files += from->nr_files;
+	st->nr_ios += from->nr_ios;
+	st->nr_bytes += from->nr_bytes;
+	st->nr_syscalls += from->nr_syscalls;
+	st->nr_verified += from->nr_verified;
+	st->nr_verify_errors += from->nr_verify_errors;
+	st->rate_lag_sum += from->rate_lag_sum;
+	if (from->rate_lag_max > st->rate_lag_max)
+		st->rate_lag_max = from->rate_lag_max;
+	st->mmap_sum += from->mmap_sum;
+	st->nr_cache_hits += from->nr_cache_hits;
+	st->nr_cache_lookups += from->nr_cache_lookups;
+	zio_hist_merge(&st->lat, &from->lat);
+}
+
+void zio_live_init(struct zio_live *live, bool hist)
+{
+	memset(live, 0, sizeof(*live));
+	live->hist = hist;
+	zio_hist_init(&live->lat);
+}
+
+/*
+ * Add a snapshot of the live statistics of a job to st. The latency
+ * histogram is copied again if the job updated it during the copy.
+ */
+void zio_live_read(struct zio_live *live, struct zio_stats *st)
+{
+	struct zio_hist lat;
+	unsigned long long nr_ios, nr_bytes;
+	unsigned int seq;
+
+	if (!live->hist) {
+		st->nr_ios += __atomic_load_n(&live->nr_ios, __ATOMIC_RELAXED);
+		st->nr_bytes += __atomic_load_n(&live->nr_bytes,
+						__ATOMIC_RELAXED);
+		return;
+	}
+
+	do {
+		seq = __atomic_load_n(&live->seq, __ATOMIC_ACQUIRE);
+		if (seq & 1)
+			continue;
+		nr_ios = __atomic_load_n(&live->nr_ios, __ATOMIC_RELAXED);
+		nr_bytes = __atomic_load_n(&live->nr_bytes, __ATOMIC_RELAXED);
+		memcpy(&lat, &live->lat, sizeof(lat));
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	} while ((seq & 1) ||
+		 __atomic_load_n(&live->seq, __ATOMIC_RELAXED) != seq);
+
+	st->nr_ios += nr_ios;
+	st->nr_bytes += nr_bytes;
+	zio_hist_merge(&st->lat, &lat);
+}
@@ -0,0 +1,512 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (C) 2026 Western Digital Corporation or its affiliates.
+ */
+
+#include "zio.h"
+
+#include <sys/mman.h>
+#include <linux/io_uring.h>
+
+#ifndef IORING_SETUP_HYBRID_IOPOLL
+#define IORING_SETUP_HYBRID_IOPOLL	(1U << 17)
+#endif
+
+/*
+ * io_uring instance. The submission and completion rings are accessed
+ * directly, without liburing.
+ */
+struct zio_uring {
+	int fd;
+	unsigned int flags;
+	unsigned int features;
+
+	/* Submission ring */
+	void *sq_ring;
+	size_t sq_ring_sz;
+	unsigned int *sq_head;
+	unsigned int *sq_tail;
+	unsigned int *sq_mask;
+	unsigned int *sq_flags;
+	unsigned int *sq_array;
+	struct io_uring_sqe *sqes;
+	size_t sqes_sz;
+
+	/* SQEs queued and not yet consumed by io_uring_enter() */
+	unsigned int nr_queued;
+
+	/* Completion ring */
+	void *cq_ring;
+	size_t cq_ring_sz;
+	unsigned int *cq_head;
+	unsigned int *cq_tail;
+	unsigned int *cq_mask;
+	struct io_uring_cqe *cqes;
+};
+
+/*
+ * System call wrappers.
+ */
+static inline int io_uring_setup(unsigned int entries,
+				 struct io_uring_params *p)
+{
+	return syscall(__NR_io_uring_setup, entries, p);
+}
+
+static inline int io_uring_enter(int fd, unsigned int to_submit,
+				 unsigned int min_complete, unsigned int flags,
+				 void *arg, size_t argsz)
+{
+	return syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+		       flags, arg, argsz);
+}
+
+static inline int io_uring_register(int fd, unsigned int opcode,
+				    void *arg, unsigned int nr_args)
+{
+	return syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+static void zio_uring_exit(struct zio_uring *ring)
+{
+	if (ring->sqes)
+		munmap(ring->sqes, ring->sqes_sz);
+	if (ring->cq_ring && ring->cq_ring != ring->sq_ring)
+		munmap(ring->cq_ring, ring->cq_ring_sz);
+	if (ring->sq_ring)
+		munmap(ring->sq_ring, ring->sq_ring_sz);
+	if (ring->fd >= 0)
+		close(ring->fd);
+	free(ring);
+}
+
+/*
+ * Register the buffers of all IO slots, so that the kernel does not have
+ * to pin the buffer pages for every IO.
+ */
+static int zio_uring_register_bufs(struct zio_params *zio,
+				   struct zio_uring *ring)
+{
+	struct iovec *iov;
+	unsigned int i;
+	int ret;
+
+	iov = calloc(zio->iodepth, sizeof(struct iovec));
+	if (!iov) {
+		fprintf(stderr, "No memory for io_uring buffers\n");
+		return -1;
+	}
+
+	for (i = 0; i < zio->iodepth; i++) {
+		iov[i].iov_base = zio->io[i].buf;
+		iov[i].iov_len = zio->buf_size;
+	}
+
+	ret = io_uring_register(ring->fd, IORING_REGISTER_BUFFERS,
+				iov, zio->iodepth);
+	if (ret < 0)
+		fprintf(stderr, "io_uring register buffers failed %d (%s)\n",
+			errno, strerror(errno));
+	free(iov);
+
+	return ret < 0 ? -1 : 0;
+}
+
+/*
+ * Create an io_uring instance and map its rings.
+ */
+static struct zio_uring *zio_uring_init(struct zio_params *zio)
+{
+	struct io_uring_params p;
+	struct zio_uring *ring;
+	void *ptr;
+
+	ring = calloc(1, sizeof(struct zio_uring));
+	if (!ring) {
+		fprintf(stderr, "No memory for io_uring\n");
+		return NULL;
+	}
+
+	memset(&p, 0, sizeof(p));
+	if (zio->sqpoll) {
+		p.flags |= IORING_SETUP_SQPOLL;
+		p.sq_thread_idle = zio->sqpoll_idle;
+	}
+	if (zio->poll != ZIO_POLL_NONE)
+		p.flags |= IORING_SETUP_IOPOLL;
+	if (zio->poll == ZIO_POLL_HYBRID)
+		p.flags |= IORING_SETUP_HYBRID_IOPOLL;
+
+	ring->fd = io_uring_setup(zio->iodepth, &p);
+	if (ring->fd < 0) {
+		fprintf(stderr, "io_uring_setup failed %d (%s)\n",
+			errno, strerror(errno));
+		free(ring);
+		return NULL;
+	}
+	ring->flags = p.flags;
+	ring->features = p.features;
+
+	if (zio->rate_ns && !(ring->features & IORING_FEAT_EXT_ARG)) {
+		fprintf(stderr,
+			"io_uring completion wait timeout not supported\n");
+		close(ring->fd);
+		free(ring);
+		return NULL;
+	}
+
+	/* Map the rings */
+	ring->sq_ring_sz = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+	ring->cq_ring_sz = p.cq_off.cqes +
+		p.cq_entries * sizeof(struct io_uring_cqe);
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		if (ring->cq_ring_sz > ring->sq_ring_sz)
+			ring->sq_ring_sz = ring->cq_ring_sz;
+		ring->cq_ring_sz = ring->sq_ring_sz;
+	}
+
+	ptr = mmap(NULL, ring->sq_ring_sz, PROT_READ | PROT_WRITE,
+		   MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+	if (ptr == MAP_FAILED)
+		goto err;
+	ring->sq_ring = ptr;
+
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		ring->cq_ring = ring->sq_ring;
+	} else {
+		ptr = mmap(NULL, ring->cq_ring_sz, PROT_READ | PROT_WRITE,
+			   MAP_SHARED | MAP_POPULATE, ring->fd,
+			   IORING_OFF_CQ_RING);
+		if (ptr == MAP_FAILED)
+			goto err;
+		ring->cq_ring = ptr;
+	}
+
+	ring->sqes_sz = p.sq_entries * sizeof(struct io_uring_sqe);
+	ptr = mmap(NULL, ring->sqes_sz, PROT_READ | PROT_WRITE,
+		   MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+	if (ptr == MAP_FAILED) {
+		ring->sqes = NULL;
+		goto err;
+	}
+	ring->sqes = ptr;
+
+	ring->sq_head = ring->sq_ring + p.sq_off.head;
+	ring->sq_tail = ring->sq_ring + p.sq_off.tail;
+	ring->sq_mask = ring->sq_ring + p.sq_off.ring_mask;
+	ring->sq_flags = ring->sq_ring + p.sq_off.flags;
+	ring->sq_array = ring->sq_ring + p.sq_off.array;
+
+	ring->cq_head = ring->cq_ring + p.cq_off.head;
+	ring->cq_tail = ring->cq_ring + p.cq_off.tail;
+	ring->cq_mask = ring->cq_ring + p.cq_off.ring_mask;
+	ring->cqes = ring->cq_ring + p.cq_off.cqes;
+
+	/* Register the file */
+	if (zio->fixed_files &&
+	    io_uring_register(ring->fd, IORING_REGISTER_FILES,
+			      &zio->fd, 1) < 0) {
+		fprintf(stderr, "io_uring register file failed %d (%s)\n",
+			errno, strerror(errno));
+		zio_uring_exit(ring);
+		return NULL;
+	}
+
+	/* Register the IO buffers */
+	if (zio->fixed_bufs && zio_uring_register_bufs(zio, ring)) {
+		zio_uring_exit(ring);
+		return NULL;
+	}
+
+	return ring;
+
+err:
+	fprintf(stderr, "io_uring mmap failed %d (%s)\n",
+		errno, strerror(errno));
+	zio_uring_exit(ring);
+	return NULL;
+}
+
+/*
+ * Prepare SQEs for all free IO slots. Return the number of SQEs queued.
+ */
+static unsigned int zio_uring_queue(struct zio_params *zio)
+{
+	struct zio_uring *ring = zio->uring;
+	unsigned int tail = *ring->sq_tail;
+	unsigned long long now = zio_nsec();
+	unsigned int i, idx, n = 0;
+	struct io_uring_sqe *sqe;
+	struct zio *io;
+
+	for (i = 0; i < zio->iodepth; i++) {
+		if (zio_done(zio) || !zio_io_due(zio, now))
+			break;
+
+		io = &zio->io[i];
+		if (io->nr >= 0)
+			continue;
+
+		zio_next_ofst(zio);
+
+		idx = tail & *ring->sq_mask;
+		sqe = &ring->sqes[idx];
+		memset(sqe, 0, sizeof(struct io_uring_sqe));
+		if (zio->read) {
+			sqe->opcode = IORING_OP_READV;
+			sqe->off = zio->ioofst;
+		} else {
+			sqe->opcode = IORING_OP_WRITEV;
+			if (zio->append)
+				sqe->off = 0;
+			else
+				sqe->off = zio->ioofst;
+		}
+		if (zio->fixed_files) {
+			sqe->fd = 0;
+			sqe->flags |= IOSQE_FIXED_FILE;
+		} else {
+			sqe->fd = zio->fd;
+		}
+		if (zio->fixed_bufs) {
+			/* Without --iovec, IOs use a single buffer */
+			sqe->opcode = zio->read ? IORING_OP_READ_FIXED :
+				IORING_OP_WRITE_FIXED;
+			sqe->addr = (unsigned long)io->iov[0].iov_base;
+			sqe->len = io->iov[0].iov_len;
+			sqe->buf_index = i;
+		} else {
+			sqe->addr = (unsigned long)io->iov;
+			sqe->len = zio->iovcnt;
+		}
+		sqe->rw_flags = zio->ioflags;
+		sqe->user_data = (unsigned long)io;
+		ring->sq_array[idx] = idx;
+
+		io->nr = zio->nr_ios;
+		io->ofst = sqe->off;
+		io->issue_ns = zio_rate_next(zio);
+		if (zio->verify && !zio->read) {
+			/* Do not account the buffer fill in the IO latency */
+			zio_verify_fill(zio, io, zio->ioofst);
+			now = zio_nsec();
+		}
+		zio_io_issue(zio, io, now);
+
+		zio_vprintf(zio, "%05d: %s %zu B at %ld issued\n",
+			    io->nr,
+			    zio->read ? "READ" : "WRITE",
+			    zio->iosize, zio->ioofst);
+
+		tail++;
+		n++;
+		zio->nr_ios++;
+
+		zio->ioofst += zio->iosize;
+	}
+
+	/* Make the SQEs visible to the kernel */
+	if (n)
+		__atomic_store_n(ring->sq_tail, tail, __ATOMIC_RELEASE);
+	ring->nr_queued += n;
+
+	return n;
+}
+
+/*
+ * Submit queued SQEs and wait for at least wait_nr completions, for at
+ * most timeout_ns if timeout_ns is not 0. With SQPOLL, the kernel thread
+ * picks up the SQEs and io_uring_enter() is needed only to wake it up or
+ * to wait. With IOPOLL, waiting for completions polls the device and
+ * timeouts are not supported: do a single poll pass instead.
+ *
+ * The kernel may consume only part of the queued SQEs, in which case it
+ * does not wait for completions. The remaining SQEs stay queued and are
+ * submitted again with the next call. Return the number of IOs submitted.
+ */
+static int zio_uring_submit(struct zio_params *zio, unsigned int wait_nr,
+			    unsigned long long timeout_ns)
+{
+	struct zio_uring *ring = zio->uring;
+	unsigned int to_submit = ring->nr_queued;
+	unsigned int submitted = 0;
+	struct io_uring_getevents_arg arg;
+	struct __kernel_timespec ts;
+	unsigned int flags = 0;
+	void *argp = NULL;
+	size_t argsz = 0;
+	int ret;
+
+	if (wait_nr) {
+		flags |= IORING_ENTER_GETEVENTS;
+		if (timeout_ns && (ring->flags & IORING_SETUP_IOPOLL)) {
+			wait_nr = 0;
+		} else if (timeout_ns) {
+			ts.tv_sec = timeout_ns / 1000000000ULL;
+			ts.tv_nsec = timeout_ns % 1000000000ULL;
+			memset(&arg, 0, sizeof(arg));
+			arg.ts = (unsigned long)&ts;
+			argp = &arg;
+			argsz = sizeof(arg);
+			flags |= IORING_ENTER_EXT_ARG;
+		}
+	}
+
+	if (ring->flags & IORING_SETUP_SQPOLL) {
+		/* The kernel thread consumes the SQEs */
+		submitted = to_submit;
+		to_submit = 0;
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		if (__atomic_load_n(ring->sq_flags, __ATOMIC_RELAXED) &
+		    IORING_SQ_NEED_WAKEUP)
+			flags |= IORING_ENTER_SQ_WAKEUP;
+	}
+
+	if (to_submit || flags) {
+		do {
+			zio->nr_syscalls++;
+			ret = io_uring_enter(ring->fd, to_submit, wait_nr,
+					     flags, argp, argsz);
+		} while (ret < 0 && errno == EINTR);
+		if (ret < 0 && errno != ETIME && errno != EAGAIN &&
+		    errno != EBUSY) {
+			fprintf(stderr, "io_uring_enter failed %d (%s)\n",
+				errno, strerror(errno));
+			return -1;
+		}
+		/*
+		 * On a timeout or a full completion ring, nothing was
+		 * submitted: reap completions and submit again.
+		 */
+		if (ret > 0 && to_submit)
+			submitted = ret;
+	}
+
+	ring->nr_queued -= submitted;
+
+	return submitted;
+}
+
+/*
+ * Reap at most batch_max completions. Return the number of IOs completed.
+ */
+static int zio_uring_reap(struct zio_params *zio)
+{
+	struct zio_uring *ring = zio->uring;
+	unsigned int head = *ring->cq_head;
+	unsigned long long now;
+	unsigned int tail;
+	struct io_uring_cqe *cqe;
+	struct zio *io;
+	int n = 0;
+
+	tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+	if (head == tail)
+		return 0;
+
+	now = zio_nsec();
+	while (head != tail && n < (int)zio->batch_max) {
+		cqe = &ring->cqes[head & *ring->cq_mask];
+		io = (struct zio *)(unsigned long)cqe->user_data;
+
+		if (cqe->res < 0) {
+			fprintf(stderr, "%05d: %s %zu B at %ld failed %d (%s)\n",
+				io->nr,
+				zio->read ? "READ" : "WRITE",
+				zio->iosize, io->ofst,
+				-cqe->res, strerror(-cqe->res));
+			__atomic_store_n(ring->cq_head, head + 1,
+					 __ATOMIC_RELEASE);
+			return -1;
+		}
+
+		zio_vprintf(zio, "%05d: %s %zu B at %ld completed\n",
+			    io->nr,
+			    zio->read ? "READ" : "WRITE",
+			    zio->iosize, io->ofst);
+
+		zio_io_done(zio, io, now);
+		if (zio->verify && zio->read)
+			zio_verify_check(zio, io, io->ofst, cqe->res);
+		io->nr = -1;
+		head++;
+		n++;
+	}
+
+	__atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+
+	return n;
+}
+
+/*
+ * io_uring run.
+ */
+int zio_run_uring(struct zio_params *zio)
+{
+	unsigned long long now, next, timeout;
+	int n, queued, in_flight = 0;
+	unsigned int wait_nr;
+	int ret = 0;
+
+	zio->uring = zio_uring_init(zio);
+	if (!zio->uring)
+		return -1;
+
+	/* Do IOs until submission stops */
+	while (1) {
+
+		n = zio_uring_queue(zio);
+		queued = zio->uring->nr_queued;
+		if (!queued && !in_flight) {
+			if (zio_done(zio))
+				break;
+			/* With a rate limit, sleep until the next IO is due */
+			zio_wait_until(zio_rate_next(zio));
+			continue;
+		}
+
+		/*
+		 * Wait for completions only if no IO slot is free or if
+		 * there are no more IOs to issue. With a rate limit, do not
+		 * wait past the time the next IO is due if an IO slot is free.
+		 * The kernel waits only if all queued SQEs are submitted, so
+		 * the queued IOs can be counted as in flight.
+		 */
+		wait_nr = 0;
+		timeout = 0;
+		if (!n || in_flight + queued >= (int)zio->iodepth ||
+		    zio_done(zio)) {
+			wait_nr = zio->batch_min;
+			if (wait_nr > (unsigned int)(in_flight + queued))
+				wait_nr = in_flight + queued;
+		}
+		if (wait_nr && zio->rate_ns && !zio_done(zio) &&
+		    in_flight + queued < (int)zio->iodepth) {
+			next = zio_rate_next(zio);
+			now = zio_nsec();
+			if (next > now)
+				timeout = next - now;
+			else
+				wait_nr = 0;
+		}
+		ret = zio_uring_submit(zio, wait_nr, timeout);
+		if (ret < 0)
+			break;
+
+		in_flight += ret;
+		ret = 0;
+
+		n = zio_uring_reap(zio);
+		if (n < 0) {
+			ret = -1;
+			break;
+		}
+
+		in_flight -= n;
+	}
+
+	zio_uring_exit(zio->uring);
+	zio->uring = NULL;
+
+	return ret;
+}
@@ -0,0 +1,261 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (C) 2026 Western Digital Corporation or its affiliates.
+ */
+
+#include "zio.h"
+
+#include <stdint.h>
+#include <stdarg.h>
+
+/*
+ * In verify mode, every block written starts with a header identifying the
+ * file, the offset and the IO that wrote the block, followed by a payload
+ * generated from these fields and from the run seed.
+ */
+#define ZIO_VERIFY_MAGIC	0x5a494f5645524946ULL	/* "ZIOVERIF" */
+
+struct zio_vhdr {
+	uint64_t magic;
+	uint64_t file;
+	uint64_t ofst;
+	uint64_t seq;
+	uint64_t seed;
+	uint64_t rsvd[3];
+};
+
+/*
+ * The payload is generated and checked 32 B at a time using GCC vector
+ * extensions, which the compiler maps to the SIMD instructions of the
+ * target (SSE2 by default on x86_64, AVX2 with -march=native, NEON on
+ * arm64).
+ */
+typedef uint64_t zio_v64 __attribute__((vector_size(32)));
+
+#define ZIO_V64_WORDS		(sizeof(zio_v64) / sizeof(uint64_t))
+#define ZIO_VERIFY_STEP		0x9e3779b97f4a7c15ULL
+
+/* Number of errors reported per file */
+#define ZIO_VERIFY_MAX_REPORTS	16
+
+static uint64_t zio_verify_mix(uint64_t x)
+{
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+
+	return x ^ (x >> 31);
+}
+
+static uint64_t zio_verify_base(struct zio_vhdr *hdr)
+{
+	return zio_verify_mix(hdr->seed ^
+			      zio_verify_mix(hdr->file ^
+					     zio_verify_mix(hdr->ofst)));
+}
+
+/*
+ * Word i of a block payload is base + i * ZIO_VERIFY_STEP. Initialize v
+ * with the first ZIO_V64_WORDS payload words.
+ */
+static void zio_verify_first(zio_v64 *v, uint64_t base)
+{
+	unsigned int i;
+
+	for (i = 0; i < ZIO_V64_WORDS; i++)
+		(*v)[i] = base + i * ZIO_VERIFY_STEP;
+}
+
+static void zio_verify_fill_blk(struct zio_params *zio, void *blk,
+				loff_t ofst)
+{
+	struct zio_vhdr *hdr = blk;
+	zio_v64 *p = blk + sizeof(struct zio_vhdr);
+	zio_v64 *end = blk + zio->blksize;
+	zio_v64 v, step;
+
+	hdr->magic = ZIO_VERIFY_MAGIC;
+	hdr->file = zio->ino;
+	hdr->ofst = ofst;
+	hdr->seq = zio->nr_ios;
+	hdr->seed = zio->verify_seed;
+	memset(hdr->rsvd, 0, sizeof(hdr->rsvd));
+
+	zio_verify_first(&v, zio_verify_base(hdr));
+	step = (zio_v64){} + ZIO_V64_WORDS * ZIO_VERIFY_STEP;
+	while (p < end) {
+		*p++ = v;
+		v += step;
+	}
+}
+
+/*
+ * Return the index of the first payload word of a block that differs from
+ * its expected value, or -1 if the payload is correct.
+ */
+static int zio_verify_payload(struct zio_params *zio, void *blk)
+{
+	struct zio_vhdr *hdr = blk;
+	zio_v64 *p = blk + sizeof(struct zio_vhdr);
+	zio_v64 *end = blk + zio->blksize;
+	zio_v64 v, step, diff = {};
+	uint64_t *w, base;
+	unsigned int i, n;
+
+	base = zio_verify_base(hdr);
+	zio_verify_first(&v, base);
+	step = (zio_v64){} + ZIO_V64_WORDS * ZIO_VERIFY_STEP;
+	while (p < end) {
+		diff |= *p++ ^ v;
+		v += step;
+	}
+
+	for (i = 0; i < ZIO_V64_WORDS; i++)
+		if (diff[i])
+			break;
+	if (i == ZIO_V64_WORDS)
+		return -1;
+
+	/* Slow path: locate the first bad word */
+	w = blk + sizeof(struct zio_vhdr);
+	n = (zio->blksize - sizeof(struct zio_vhdr)) / sizeof(uint64_t);
+	for (i = 0; i < n; i++) {
+		if (w[i] != base + i * ZIO_VERIFY_STEP)
+			return i;
+	}
+
+	return -1;
+}
+
+static void zio_verify_error(struct zio_params *zio, loff_t ofst,
+			     const char *fmt, ...)
+	__attribute__ ((format (printf, 3, 4)));
+
+static void zio_verify_error(struct zio_params *zio, loff_t ofst,
+			     const char *fmt, ...)
+{
+	va_list ap;
+
+	zio->nr_verify_errors++;
+	if (zio->nr_verify_errors > ZIO_VERIFY_MAX_REPORTS)
+		return;
+
+	fprintf(stderr, "%s: block at %lld: ", zio->path, (long long)ofst);
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+	fprintf(stderr, "\n");
+
+	if (zio->nr_verify_errors == ZIO_VERIFY_MAX_REPORTS)
+		fprintf(stderr, "%s: not reporting more errors\n", zio->path);
+}
+
+static void zio_verify_check_blk(struct zio_params *zio, void *blk,
+				 loff_t ofst)
+{
+	struct zio_vhdr *hdr = blk;
+	int w;
+
+	zio->nr_verified++;
+
+	if (hdr->magic != ZIO_VERIFY_MAGIC) {
+		zio_verify_error(zio, ofst, "no verify header");
+		return;
+	}
+
+	if (hdr->file != zio->ino) {
+		zio_verify_error(zio, ofst,
+				 "block of file %llu, expected file %llu",
+				 (unsigned long long)hdr->file,
+				 (unsigned long long)zio->ino);
+		return;
+	}
+
+	if (hdr->seed != zio->verify_seed) {
+		zio_verify_error(zio, ofst,
+				 "block seed %llu, expected seed %llu",
+				 (unsigned long long)hdr->seed,
+				 (unsigned long long)zio->verify_seed);
+		return;
+	}
+
+	if ((loff_t)hdr->ofst != ofst) {
+		zio_verify_error(zio, ofst,
+				 "misplaced block written by IO %llu, "
+				 "expected offset %llu, actual offset %lld",
+				 (unsigned long long)hdr->seq,
+				 (unsigned long long)hdr->ofst,
+				 (long long)ofst);
+		return;
+	}
+
+	w = zio_verify_payload(zio, blk);
+	if (w >= 0)
+		zio_verify_error(zio, ofst,
+				 "corrupted data at byte %zu of block written "
+				 "by IO %llu",
+				 sizeof(struct zio_vhdr) + w * sizeof(uint64_t),
+				 (unsigned long long)hdr->seq);
+}
+
+/*
+ * Stamp all the blocks of an IO buffer to be written at ofst.
+ */
+void zio_verify_fill(struct zio_params *zio, struct zio *io, loff_t ofst)
+{
+	unsigned int i;
+	size_t b;
+
+	for (i = 0; i < zio->iovcnt; i++) {
+		for (b = 0; b < io->iov[i].iov_len; b += zio->blksize) {
+			zio_verify_fill_blk(zio, io->iov[i].iov_base + b,
+					    ofst);
+			ofst += zio->blksize;
+		}
+	}
+}
+
+/*
+ * Check the full blocks of the first len bytes of an IO buffer read
+ * from ofst.
+ */
+void zio_verify_check(struct zio_params *zio, struct zio *io, loff_t ofst,
+		      size_t len)
+{
+	unsigned int i;
+	size_t b;
+
+	for (i = 0; i < zio->iovcnt; i++) {
+		for (b = 0; b < io->iov[i].iov_len; b += zio->blksize) {
+			if (len < zio->blksize)
+				return;
+			zio_verify_check_blk(zio, io->iov[i].iov_base + b,
+					     ofst);
+			ofst += zio->blksize;
+			len -= zio->blksize;
+		}
+	}
+}
+
+/*
+ * Check that the IO size and buffers can be used in verify mode.
+ */
+int zio_verify_init(struct zio_params *zio)
+{
+	if (zio->blksize < 2 * sizeof(struct zio_vhdr) ||
+	    zio->blksize % sizeof(zio_v64)) {
+		fprintf(stderr, "%s: block size %zu B not supported for verify\n",
+			zio->path, zio->blksize);
+		return -1;
+	}
+
+	if (zio->iosize % zio->blksize ||
+	    (zio->iovec && zio->iovlen % zio->blksize) ||
+	    (zio->rand_align && zio->rand_align % zio->blksize)) {
+		fprintf(stderr,
+			"IO size and alignment must be multiples of the %zu B block size for verify\n",
+			zio->blksize);
+		return -1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,217 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (C) 2026 Western Digital Corporation or its affiliates.
+ *
+ * Compare the memory used and the time taken to scan the zones of a device
+ * for an array of struct blk_zone and for the libzonefs zone table. The
+ * zones are generated, so no device is needed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "zonefs.h"
+
+/* Zone size of the generated zones: 256 MiB */
+#define ZTABLE_ZONE_SECTORS	(256ULL * 1024 * 2)
+
+static unsigned long long ztable_nsec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * Generate the zones: 1 % of conventional zones, then sequential zones of
+ * which 1 in 4 is empty, 1 in 4 full and the others partially written.
+ */
+static void ztable_gen_zone(unsigned int zno, unsigned int nr_conv,
+			    struct blk_zone *z)
+{
+	memset(z, 0, sizeof(*z));
+	z->start = zno * ZTABLE_ZONE_SECTORS;
+	z->len = ZTABLE_ZONE_SECTORS;
+	z->capacity = ZTABLE_ZONE_SECTORS;
+
+	if (zno < nr_conv) {
+		z->type = BLK_ZONE_TYPE_CONVENTIONAL;
+		z->cond = BLK_ZONE_COND_NOT_WP;
+		z->wp = z->start + z->len;
+		return;
+	}
+
+	z->type = BLK_ZONE_TYPE_SEQWRITE_REQ;
+	switch (zno & 3) {
+	case 0:
+		z->cond = BLK_ZONE_COND_EMPTY;
+		z->wp = z->start;
+		break;
+	case 1:
+		z->cond = BLK_ZONE_COND_FULL;
+		z->wp = z->start + z->len;
+		break;
+	default:
+		z->cond = BLK_ZONE_COND_CLOSED;
+		z->wp = z->start + z->len / 2;
+		break;
+	}
+}
+
+/*
+ * Count the conventional and non-empty zones, as done to plan the zone
+ * resets and the conventional zone wipe.
+ */
+static unsigned int ztable_scan_blkz(struct blk_zone *zones,
+				     unsigned int nr_zones,
+				     unsigned int *nr_conv)
+{
+	unsigned int i, nr_used = 0;
+
+	*nr_conv = 0;
+	for (i = 0; i < nr_zones; i++) {
+		if (zones[i].type == BLK_ZONE_TYPE_CONVENTIONAL)
+			(*nr_conv)++;
+		else if (zones[i].wp != zones[i].start)
+			nr_used++;
+	}
+
+	return nr_used;
+}
+
+static unsigned int ztable_scan_table(struct zonefs_dev *dev,
+				      unsigned int *nr_conv)
+{
+	unsigned int i, nr_used = 0;
+
+	*nr_conv = 0;
+	for (i = 0; i < dev->nr_zones; i++) {
+		if (zonefs_zone_is_conv(dev, i))
+			(*nr_conv)++;
+		else if (zonefs_zone_wp(dev, i) != zonefs_zone_start(dev, i))
+			nr_used++;
+	}
+
+	return nr_used;
+}
+
+static void ztable_print(const char *name, size_t size,
+			 unsigned long long ns, unsigned int loops,
+			 unsigned int nr_conv, unsigned int nr_used)
+{
+	unsigned long long scan_ns = ns / loops;
+
+	printf("%-22s: %8zu KiB, %llu.%03llu ms per scan "
+	       "(%u conventional, %u non-empty)\n",
+	       name, size / 1024,
+	       scan_ns / 1000000, (scan_ns % 1000000) / 1000,
+	       nr_conv, nr_used);
+}
+
+static void ztable_usage(char *cmd)
+{
+	printf("Usage: %s [options]\n",
+	       cmd);
+	printf("Options:\n"
+	       "    -h | --help     : print usage and exit\n"
+	       "    --nrzones=<n>   : Number of zones (default: 4194304)\n"
+	       "    --loops=<n>     : Number of scans (default: 10)\n");
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int nr_zones = 4U * 1024 * 1024, loops = 10;
+	unsigned long long nr_used = 0;
+	unsigned int i, nr_conv = 0;
+	struct zonefs_dev dev;
+	struct blk_zone *zones, z;
+	unsigned long long start;
+	size_t size;
+	int n;
+
+	/* Parse command line */
+	for (i = 1; i < (unsigned int)argc; i++) {
+
+		if (strcmp(argv[i], "-h") == 0 ||
+		    strcmp(argv[i], "--help") == 0) {
+			ztable_usage(argv[0]);
+			return 0;
+		}
+
+		if (strncmp(argv[i], "--nrzones=", 10) == 0) {
+
+			n = atoi(argv[i] + 10);
+			if (n <= 0) {
+				fprintf(stderr, "Invalid number of zones\n");
+				return 1;
+			}
+			nr_zones = n;
+
+		} else if (strncmp(argv[i], "--loops=", 8) == 0) {
+
+			n = atoi(argv[i] + 8);
+			if (n <= 0) {
+				fprintf(stderr, "Invalid number of loops\n");
+				return 1;
+			}
+			loops = n;
+
+		} else {
+
+			fprintf(stderr, "Invalid option \"%s\"\n", argv[i]);
+			return 1;
+
+		}
+	}
+
+	memset(&dev, 0, sizeof(dev));
+	dev.nr_zones = nr_zones;
+	dev.zone_nr_sectors = ZTABLE_ZONE_SECTORS;
+	dev.capacity = nr_zones * ZTABLE_ZONE_SECTORS;
+
+	zones = calloc(nr_zones, sizeof(struct blk_zone));
+	dev.zones.wp_ofst = calloc(nr_zones, sizeof(__u32));
+	dev.zones.type = calloc(nr_zones, sizeof(__u8));
+	dev.zones.cond = calloc(nr_zones, sizeof(__u8));
+	if (!zones || !dev.zones.wp_ofst || !dev.zones.type ||
+	    !dev.zones.cond) {
+		fprintf(stderr, "Not enough memory\n");
+		return 1;
+	}
+
+	for (i = 0; i < nr_zones; i++) {
+		ztable_gen_zone(i, nr_zones / 100, &z);
+		zones[i] = z;
+		dev.zones.wp_ofst[i] = z.wp - z.start;
+		dev.zones.type[i] = z.type;
+		dev.zones.cond[i] = z.cond;
+	}
+
+	printf("%u zones:\n", nr_zones);
+
+	start = ztable_nsec();
+	for (i = 0; i < loops; i++)
+		nr_used += ztable_scan_blkz(zones, nr_zones, &nr_conv);
+	size = nr_zones * sizeof(struct blk_zone);
+	ztable_print("struct blk_zone array", size, ztable_nsec() - start,
+		     loops, nr_conv, nr_used / loops);
+
+	nr_used = 0;
+	start = ztable_nsec();
+	for (i = 0; i < loops; i++)
+		nr_used += ztable_scan_table(&dev, &nr_conv);
+	size = nr_zones * (sizeof(__u32) + 2 * sizeof(__u8));
+	ztable_print("zone table", size, ztable_nsec() - start,
+		     loops, nr_conv, nr_used / loops);
+
+	free(zones);
+	free(dev.zones.wp_ofst);
+	free(dev.zones.type);
+	free(dev.zones.cond);
+
+	return 0;
+}
@@ -395,7 +395,9 @@ for ((r=1; r<=${nrloops}; r++)); do
 		echo -e "$status"
 
 		if [ -f "${logdir}/.zonefs_test_nullbn" ]; then
-			destroy_nullb "$(cat ${logdir}/.zonefs_test_nullbn)"
+			for n in $(cat ${logdir}/.zonefs_test_nullbn); do
+				destroy_nullb "$n"
+			done
 		fi
 
 		if [ "$aborted" == 1 ]; then
@@ -19,6 +19,13 @@ BuildRequires:	gcc
 This package provides the mkzonefs (and mkfs.zonefs) user utility
 to format zoned block devices for use with the zonefs file system.
 
+%package devel
+Summary: Development header files for libzonefs
+Requires: %{name}%{?_isa} = %{version}-%{release}
+
+%description devel
+This package provides development header files for libzonefs.
+
 %prep
 %autosetup
 
@@ -29,14 +36,25 @@ sh autogen.sh
 
 %install
 %make_install
+find %{buildroot} -name '*.la' -delete
+
+%ldconfig_scriptlets
 
 %files
 %{_sbindir}/*
+%{_libdir}/libzonefs.so.*
 %{_mandir}/man8/*
 
 %license COPYING.GPL
 %doc README.md CONTRIBUTING
 
+%files devel
+%{_includedir}/zonefs.h
+%{_libdir}/libzonefs.so
+%{_libdir}/pkgconfig/libzonefs.pc
+
+%license COPYING.GPL
+
 %changelog
 * Tue Jan 31 2023 Damien Le Moal <damien.lemoal@wdc.com> 1.6.0-1
 - Version 1.6.0 initial package